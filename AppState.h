@@ -6,7 +6,9 @@ enum class Screen {
     Music,
     Video,
     Settings,
-    About
+    About,
+    Photos,
+    Playlists
 };
 
 enum class SettingsInputMode {
@@ -26,10 +28,12 @@ struct AppState {
     Screen current = Screen::MainMenu;
     int selected = 0;
     float visualOffset = 0.0f;
+    int openPlaylist = -1; // Playlists screen: -1 lists the playlists
 
     // Settings → Jellyfin setup
     SettingsInputMode inputMode = SettingsInputMode::None;
     std::string jellyfinUrl;
     std::string jellyfinUser;
     std::string jellyfinPass;
+    bool jellyfinVerifyTls = true;
 };
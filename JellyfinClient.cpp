@@ -1,7 +1,10 @@
 #include "JellyfinClient.h"
 #include <curl/curl.h>
 #include <nlohmann/json.hpp>
+#include <chrono>
+#include <cstdio>
 #include <sstream>
+#include <unistd.h>
 
 using json = nlohmann::json;
 
@@ -11,8 +14,47 @@ static size_t write_cb(void* data, size_t size, size_t nmemb, void* userp) {
     return size * nmemb;
 }
 
+static size_t file_write_cb(void* data, size_t size, size_t nmemb, void* userp) {
+    return fwrite(data, size, nmemb, static_cast<FILE*>(userp)) * size;
+}
+
+static int cancel_cb(void* userp, curl_off_t, curl_off_t, curl_off_t, curl_off_t) {
+    return static_cast<const std::atomic<bool>*>(userp)->load() ? 1 : 0; // non-zero aborts
+}
+
+// Aborts the transfer on `curl` once `cancel` is set. libcurl checks about once a second.
+static void setCancel(CURL* curl, const std::atomic<bool>& cancel) {
+    curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 0L);
+    curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, cancel_cb);
+    curl_easy_setopt(curl, CURLOPT_XFERINFODATA, &cancel);
+}
+
+// From Settings; read by every request, whichever thread makes it
+static std::atomic<bool> verifyTls{true};
+
+static void setTls(CURL* curl) {
+    // Off only for a home server with a self-signed certificate, by choice in Settings
+    long verify = verifyTls ? 1L : 0L;
+    curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, verify);
+    curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, verify ? 2L : 0L);
+}
+
+static std::string trimmedUrl(const std::string& serverUrl) {
+    if (!serverUrl.empty() && serverUrl.back() == '/') return serverUrl.substr(0, serverUrl.size() - 1);
+    return serverUrl;
+}
+
+// Headers for a request made with `accessToken`. Free with curl_slist_free_all.
+static curl_slist* authHeaders(const std::string& accessToken, bool json) {
+    curl_slist* headers = nullptr;
+    if (!accessToken.empty()) headers = curl_slist_append(headers, ("X-Emby-Token: " + accessToken).c_str());
+    if (json) headers = curl_slist_append(headers, "Content-Type: application/json");
+    return headers;
+}
+
 std::vector<Song> Jellyfin::fetchSongs(const std::string& serverUrl,
-                                       const std::string& apiKey,
+                                       const std::string& accessToken,
+                                       const std::atomic<bool>& cancel,
                                        const std::string& userId,
                                        const std::string& libraryId) {
     std::vector<Song> result;
@@ -27,18 +69,19 @@ std::vector<Song> Jellyfin::fetchSongs(const std::string& serverUrl,
     if (!userId.empty()) url << "/" << userId;
     url << "/Items?Recursive=true&IncludeItemTypes=Audio&Fields=Album,Artists,ProviderIds";
     if (!libraryId.empty()) url << "&ParentId=" << libraryId;
-    if (!apiKey.empty()) url << "&api_key=" << apiKey;
 
     std::string response;
+    curl_slist* headers = authHeaders(accessToken, false);
     curl_easy_setopt(curl, CURLOPT_URL, url.str().c_str());
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
     curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_cb);
     curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
     curl_easy_setopt(curl, CURLOPT_TIMEOUT, 10L);
-    // optional: skip TLS verification for local servers (not recommended for production)
-    curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0L);
-    curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 0L);
+    setCancel(curl, cancel);
+    setTls(curl);
 
     CURLcode rc = curl_easy_perform(curl);
+    curl_slist_free_all(headers);
     if (rc != CURLE_OK) {
         curl_easy_cleanup(curl);
         return result;
@@ -61,15 +104,10 @@ std::vector<Song> Jellyfin::fetchSongs(const std::string& serverUrl,
             std::string id = it.value("Id", std::string());
             if (id.empty()) continue;
 
-            // Build a download/stream URL. Many Jellyfin endpoints accept /Items/{id}/Download
-            std::ostringstream fileUrl;
-            fileUrl << serverUrl;
-            if (serverUrl.back() == '/') fileUrl.seekp(-1, std::ios_base::end);
-            fileUrl << "/Items/" << id << "/Download";
-            if (!apiKey.empty())
-                fileUrl << "?api_key=" << apiKey;
-
-            s.filePath = fileUrl.str();
+            // Build a download URL. It doubles as the song's identity (stats are keyed
+            // by filePath), so it carries no token; download() authenticates by header.
+            s.filePath = trimmedUrl(serverUrl) + "/Items/" + id + "/Download";
+            s.jellyfinId = id;
             s.artwork = nullptr; // let the app load artwork later (or implement image fetch)
             result.push_back(std::move(s));
         }
@@ -79,4 +117,183 @@ std::vector<Song> Jellyfin::fetchSongs(const std::string& serverUrl,
 
     curl_easy_cleanup(curl);
     return result;
-}
\ No newline at end of file
+}
+
+long Jellyfin::download(const std::string& fileUrl,
+                        const std::string& accessToken,
+                        const std::string& destPath,
+                        const std::atomic<bool>& cancel) {
+    CURL* curl = curl_easy_init();
+    if (!curl) return 0;
+    FILE* out = fopen(destPath.c_str(), "wb");
+    if (!out) {
+        curl_easy_cleanup(curl);
+        return 0;
+    }
+
+    curl_slist* headers = authHeaders(accessToken, false);
+    curl_easy_setopt(curl, CURLOPT_URL, fileUrl.c_str());
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+    curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, file_write_cb);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, out);
+    setCancel(curl, cancel);
+    setTls(curl);
+    // No overall timeout, a song can be large; give up only if the transfer stalls
+    curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, 10L);
+    curl_easy_setopt(curl, CURLOPT_LOW_SPEED_LIMIT, 1L);
+    curl_easy_setopt(curl, CURLOPT_LOW_SPEED_TIME, 30L);
+
+    long status = 0;
+    CURLcode rc = curl_easy_perform(curl);
+    if (rc == CURLE_OK) curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &status);
+    curl_slist_free_all(headers);
+    curl_easy_cleanup(curl);
+    if (fclose(out) != 0 && status == 200) status = 0;
+    return status;
+}
+
+long Jellyfin::postPlayback(CURL* curl,
+                            const std::string& serverUrl,
+                            const std::string& accessToken,
+                            const std::string& endpoint,
+                            const std::string& itemId,
+                            long long positionTicks,
+                            const std::atomic<bool>& cancel) {
+    std::string url = trimmedUrl(serverUrl) + "/Sessions/" + endpoint;
+    std::string body = json{{"ItemId", itemId}, {"PositionTicks", positionTicks}, {"CanSeek", true}}.dump();
+    std::string response;
+    curl_slist* headers = authHeaders(accessToken, true);
+
+    curl_easy_reset(curl);
+    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, body.c_str());
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_cb);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
+    curl_easy_setopt(curl, CURLOPT_TIMEOUT, 10L);
+    setCancel(curl, cancel);
+    setTls(curl);
+
+    long status = 0;
+    CURLcode rc = curl_easy_perform(curl);
+    if (rc == CURLE_OK) curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &status);
+    curl_slist_free_all(headers);
+    return status;
+}
+
+// ---------------- Account ----------------
+
+void Jellyfin::Account::configure(const std::string& newServerUrl, const std::string& newUser,
+                                  const std::string& newPassword, bool newVerifyTls) {
+    std::lock_guard<std::mutex> lock(mutex);
+    verifyTls = newVerifyTls;
+    serverUrl = trimmedUrl(newServerUrl);
+    user = newUser;
+    password = newPassword;
+    current = {};
+    refused = 0;
+    changes++;
+}
+
+bool Jellyfin::Account::configured() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return !serverUrl.empty() && !user.empty();
+}
+
+unsigned Jellyfin::Account::generation() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return changes;
+}
+
+// POSTs the credentials to /Users/AuthenticateByName and fills `out` on success.
+static long authenticate(const std::string& serverUrl, const std::string& user, const std::string& password,
+                         Jellyfin::Session& out, const std::atomic<bool>& cancel) {
+    CURL* curl = curl_easy_init();
+    if (!curl) return 0;
+
+    char host[64] = {};
+    if (gethostname(host, sizeof(host) - 1) != 0) std::snprintf(host, sizeof(host), "unknown");
+    std::string identity = std::string("X-Emby-Authorization: MediaBrowser Client=\"iPodOS\", Device=\"") + host +
+                           "\", DeviceId=\"ipodos-" + host + "\", Version=\"1.0\"";
+    curl_slist* headers = authHeaders("", true);
+    headers = curl_slist_append(headers, identity.c_str());
+
+    std::string url = serverUrl + "/Users/AuthenticateByName";
+    std::string body = json{{"Username", user}, {"Pw", password}}.dump();
+    std::string response;
+    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, body.c_str());
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_cb);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
+    curl_easy_setopt(curl, CURLOPT_TIMEOUT, 10L);
+    setCancel(curl, cancel);
+    setTls(curl);
+
+    long status = 0;
+    CURLcode rc = curl_easy_perform(curl);
+    if (rc == CURLE_OK) curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &status);
+    curl_slist_free_all(headers);
+    curl_easy_cleanup(curl);
+    if (status != 200) return status;
+
+    try {
+        auto parsed = json::parse(response);
+        out.serverUrl = serverUrl;
+        out.accessToken = parsed.at("AccessToken").get<std::string>();
+        out.userId = parsed.at("User").at("Id").get<std::string>();
+    } catch (...) {
+        return 0;
+    }
+    return 200;
+}
+
+long Jellyfin::Account::session(Session& out, const std::atomic<bool>& cancel) {
+    std::string url, name, pass;
+    unsigned attempt;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        // Jellyfin issues one token per device, so a second concurrent login
+        // would revoke the first; wait for the one in progress instead. That
+        // login belongs to another caller, so keep an eye on our own cancel.
+        while (signingIn) {
+            if (cancel) return 0;
+            loginDone.wait_for(lock, std::chrono::milliseconds(100));
+        }
+        if (!current.accessToken.empty()) {
+            out = current;
+            return 200;
+        }
+        if (refused) return refused;
+        if (serverUrl.empty() || user.empty()) return 0;
+        url = serverUrl;
+        name = user;
+        pass = password;
+        attempt = changes;
+        signingIn = true;
+    }
+
+    // Unlocked, so configure() on the UI thread never waits on the network
+    Session fresh;
+    long status = authenticate(url, name, pass, fresh, cancel);
+
+    bool stale;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        signingIn = false;
+        // Credentials changed during the request; its result is for the old ones
+        stale = changes != attempt;
+        if (!stale && status == 200) current = fresh;
+        if (!stale && (status == 401 || status == 403)) refused = status;
+    }
+    loginDone.notify_all();
+    if (stale) return 0;
+    if (status == 200) out = fresh;
+    return status;
+}
+
+void Jellyfin::Account::invalidate(const std::string& accessToken) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (current.accessToken == accessToken) current = {};
+}
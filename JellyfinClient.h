@@ -1,11 +1,81 @@
 #pragma once
+#include <curl/curl.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
 #include <string>
 #include <vector>
 #include "Song.h"
 
 namespace Jellyfin {
+    // `accessToken` comes from Account::session(); it is sent as a header, never in the URL.
+    // Setting `cancel` aborts the request, as it does for every call below.
     std::vector<Song> fetchSongs(const std::string &serverUrl,
-                                 const std::string &apiKey,
+                                 const std::string &accessToken,
+                                 const std::atomic<bool> &cancel,
                                  const std::string &userId = "",
                                  const std::string &libraryId = "");
-}
\ No newline at end of file
+
+    // Saves the file behind a song's filePath to `destPath`. Returns the HTTP
+    // status, or 0 if the server was not reached, the file could not be written
+    // or `cancel` was set meanwhile.
+    long download(const std::string &fileUrl,
+                  const std::string &accessToken,
+                  const std::string &destPath,
+                  const std::atomic<bool> &cancel);
+
+    // POSTs a playback report to /Sessions/<endpoint> ("Playing", "Playing/Progress"
+    // or "Playing/Stopped"). Pass the same handle for a run of reports so the
+    // connection is reused. Returns the HTTP status, or 0 if the server was not
+    // reached or `cancel` was set.
+    long postPlayback(CURL *curl,
+                      const std::string &serverUrl,
+                      const std::string &accessToken,
+                      const std::string &endpoint,
+                      const std::string &itemId,
+                      long long positionTicks,
+                      const std::atomic<bool> &cancel);
+
+    struct Session {
+        std::string serverUrl;
+        std::string accessToken;
+        std::string userId;
+    };
+
+    // The login shared by everything that talks to the server. Jellyfin keeps one
+    // token per device, so the library sync, downloads and playback reports must
+    // share a single login rather than each signing in. Thread safe.
+    class Account {
+    public:
+        // Replaces the server and credentials from Settings and drops the current login.
+        // `verifyTls` applies to every Jellyfin request; turn it off only for a
+        // server with a self-signed certificate.
+        void configure(const std::string &serverUrl, const std::string &user, const std::string &password,
+                       bool verifyTls);
+
+        bool configured();
+        // Bumped by configure(), so callers can tell the credentials changed.
+        unsigned generation();
+
+        // Signs in on first use via /Users/AuthenticateByName. Returns 200 and
+        // fills `out`, or the status of the failed login (0 if unreachable, not
+        // configured, reconfigured meanwhile or cancelled). A refused login
+        // (401/403) is not retried until configure() is called again. The lock
+        // is not held during the request; concurrent callers wait for the one
+        // login, and stop waiting once `cancel` is set.
+        long session(Session &out, const std::atomic<bool> &cancel);
+
+        // Forgets `accessToken` after the server refused it, so the next
+        // session() signs in again.
+        void invalidate(const std::string &accessToken);
+
+    private:
+        std::mutex mutex;
+        std::condition_variable loginDone;
+        std::string serverUrl, user, password;
+        Session current;
+        unsigned changes = 0;
+        bool signingIn = false;
+        long refused = 0; // status of a refused login with the current credentials
+    };
+}
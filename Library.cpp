@@ -0,0 +1,173 @@
+#include "Library.h"
+#include "Utils.h"
+#include <taglib/fileref.h>
+#include <taglib/tag.h>
+#include <SDL2/SDL_image.h>
+#include <algorithm>
+#include <sys/stat.h>
+#include <unordered_set>
+
+namespace fs = std::filesystem;
+
+bool isSongFile(const fs::path &path) {
+    return path.extension() == ".mp3";
+}
+
+ScannedSong scanSongFile(const fs::path &path) {
+    ScannedSong scanned;
+    Song &s = scanned.song;
+    TagLib::FileRef f(path.c_str());
+    s.filePath = path;
+    if (!f.isNull() && f.tag()) {
+        TagLib::Tag *tag = f.tag();
+        s.title = tag->title().isEmpty() ? path.stem().string() : tag->title().to8Bit(true);
+        s.artist = tag->artist().to8Bit(true);
+    } else {
+        s.title = path.stem().string();
+        s.artist = "Unknown";
+    }
+    // Until the song has stats of its own, it counts as added when the file was written
+    struct stat info{};
+    if (stat(path.c_str(), &info) == 0) s.dateAdded = info.st_mtime;
+    fs::path artPath = path.parent_path() / "artwork" / (path.stem().string() + ".png");
+    if (fs::exists(artPath))
+        scanned.artwork = IMG_Load(artPath.c_str());
+    return scanned;
+}
+
+static constexpr int ARTWORK_UPLOADS_PER_FRAME = 8;
+
+LibraryIndex::~LibraryIndex() {
+    for (auto &[path, surface] : artwork) SDL_FreeSurface(surface);
+}
+
+void applyLibraryUpdate(LibraryUpdate &update, std::vector<Song> &songs, LibraryIndex &index, AppState &state) {
+    for (auto &scanned : update.songs) {
+        const std::string path = scanned.song.filePath;
+        auto existing = index.byPath.find(path);
+        if (existing != index.byPath.end()) {
+            // Keep showing the old cover until the new one is uploaded
+            if (scanned.artwork) scanned.song.artwork = songs[existing->second].artwork;
+            songs[existing->second] = std::move(scanned.song);
+        } else {
+            index.byPath.emplace(path, songs.size());
+            songs.push_back(std::move(scanned.song));
+        }
+
+        if (scanned.artwork) {
+            auto queued = index.artwork.find(path);
+            if (queued != index.artwork.end()) {
+                SDL_FreeSurface(queued->second);
+                queued->second = scanned.artwork;
+            } else {
+                index.artwork.emplace(path, scanned.artwork);
+                index.artworkOrder.push_back(path);
+            }
+            scanned.artwork = nullptr;
+        }
+    }
+    update.songs.clear();
+
+    if (!update.removed.empty()) {
+        bool onMusicList = state.current == Screen::Music;
+        std::unordered_set<std::string> removed(update.removed.begin(), update.removed.end());
+
+        // One compaction pass, however many songs went
+        size_t kept = 0;
+        for (size_t i = 0; i < songs.size(); i++) {
+            if (removed.count(songs[i].filePath)) {
+                // Songs above the cursor moved up by one; follow them
+                if (onMusicList && (int) i < state.selected) {
+                    state.selected--;
+                    state.visualOffset -= 1.0f;
+                }
+                continue;
+            }
+            if (kept != i) songs[kept] = std::move(songs[i]);
+            kept++;
+        }
+        songs.resize(kept);
+
+        index.byPath.clear();
+        for (size_t i = 0; i < songs.size(); i++) index.byPath.emplace(songs[i].filePath, i);
+        for (const auto &path : update.removed) {
+            auto queued = index.artwork.find(path);
+            if (queued == index.artwork.end()) continue;
+            SDL_FreeSurface(queued->second);
+            index.artwork.erase(queued);
+        }
+        update.removed.clear();
+
+        if (onMusicList && state.selected >= (int) songs.size())
+            state.selected = std::max(0, (int) songs.size() - 1);
+    }
+}
+
+void uploadLibraryArtwork(SDL_Renderer *renderer, std::vector<Song> &songs, LibraryIndex &index) {
+    for (int uploaded = 0; uploaded < ARTWORK_UPLOADS_PER_FRAME && !index.artworkOrder.empty();) {
+        std::string path = std::move(index.artworkOrder.front());
+        index.artworkOrder.pop_front();
+        auto queued = index.artwork.find(path);
+        if (queued == index.artwork.end()) continue; // song was removed meanwhile
+
+        SDL_Texture *tex = SDL_CreateTextureFromSurface(renderer, queued->second);
+        SDL_FreeSurface(queued->second);
+        index.artwork.erase(queued);
+        uploaded++;
+
+        auto song = index.byPath.find(path);
+        // wrap raw SDL_Texture* in shared_ptr with SDL_DestroyTexture as deleter
+        if (tex && song != index.byPath.end()) songs[song->second].artwork.reset(tex, SDL_DestroyTexture);
+        else if (tex) SDL_DestroyTexture(tex);
+    }
+}
+
+LibraryLoader::~LibraryLoader() {
+    stopping = true;
+    if (worker.joinable()) worker.join();
+    for (auto &scanned : pending.songs)
+        if (scanned.artwork) SDL_FreeSurface(scanned.artwork);
+}
+
+void LibraryLoader::start(Jellyfin::Account &jellyfin) {
+    worker = std::thread([this, &jellyfin] {
+        // ---------------- Local files ----------------
+        std::vector<ScannedSong> local;
+        std::error_code ec;
+        for (const auto &entry : fs::directory_iterator("assets/music", ec)) {
+            if (stopping) return;
+            if (isSongFile(entry.path()))
+                local.push_back(scanSongFile(entry.path()));
+        }
+        startupTrace("library scanned");
+        publish(std::move(local));
+
+        // ---------------- Jellyfin ----------------
+        if (!jellyfin.configured()) return;
+        Jellyfin::Session session;
+        long status = jellyfin.session(session, stopping);
+        if (stopping) return;
+        if (status != 200) {
+            SDL_Log("Jellyfin login failed (HTTP %ld), library not synced", status);
+            return;
+        }
+        std::vector<ScannedSong> remote;
+        for (auto &s : loadJellyfinSongs(nullptr, session.serverUrl, session.accessToken, stopping, session.userId))
+            remote.push_back({std::move(s), nullptr});
+        startupTrace("jellyfin synced");
+        publish(std::move(remote));
+    });
+}
+
+void LibraryLoader::publish(std::vector<ScannedSong> &&batch) {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto &scanned : batch) pending.songs.push_back(std::move(scanned));
+}
+
+bool LibraryLoader::poll(LibraryUpdate &out) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (pending.songs.empty()) return false;
+    for (auto &scanned : pending.songs) out.songs.push_back(std::move(scanned));
+    pending.songs.clear();
+    return true;
+}
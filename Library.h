@@ -0,0 +1,76 @@
+#pragma once
+#include <SDL2/SDL.h>
+#include <atomic>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "AppState.h"
+#include "JellyfinClient.h"
+#include "Song.h"
+
+// A song read off the render thread. Artwork stays a surface until the
+// render thread uploads it, since SDL_Renderer is not thread safe.
+struct ScannedSong {
+    Song song;
+    SDL_Surface *artwork = nullptr;
+};
+
+// Songs added, changed or removed since the last poll, matched by filePath.
+struct LibraryUpdate {
+    std::vector<ScannedSong> songs;
+    std::vector<std::string> removed;
+
+    bool empty() const { return songs.empty() && removed.empty(); }
+};
+
+// True for the files the library picks up from disk.
+bool isSongFile(const std::filesystem::path &path);
+
+// Reads tags and artwork for a single file. Safe to call from any thread.
+ScannedSong scanSongFile(const std::filesystem::path &path);
+
+// Render-thread bookkeeping for `songs`, kept between library updates.
+struct LibraryIndex {
+    std::unordered_map<std::string, size_t> byPath; // filePath -> index into songs
+
+    // Artwork waiting for upload, oldest first. A path can be queued once;
+    // a newer scan of it replaces the surface in place.
+    std::unordered_map<std::string, SDL_Surface *> artwork;
+    std::deque<std::string> artworkOrder;
+
+    ~LibraryIndex();
+};
+
+// Replaces known songs in place, appends new ones and drops removed ones.
+// Artwork is queued for uploadLibraryArtwork. Keeps the Music list selection
+// on the same song. Must be called on the render thread.
+void applyLibraryUpdate(LibraryUpdate &update, std::vector<Song> &songs, LibraryIndex &index, AppState &state);
+
+// Uploads a few queued artwork surfaces, so a large scan never stalls one
+// frame. Call once per frame on the render thread.
+void uploadLibraryArtwork(SDL_Renderer *renderer, std::vector<Song> &songs, LibraryIndex &index);
+
+// Scans assets/music and then syncs Jellyfin on a worker thread so that
+// the first frame does not wait for the library.
+class LibraryLoader {
+public:
+    ~LibraryLoader();
+
+    // `jellyfin` must outlive the loader.
+    void start(Jellyfin::Account &jellyfin);
+
+    // Moves whatever the worker has finished into `out`. Returns false if there was nothing new.
+    bool poll(LibraryUpdate &out);
+
+private:
+    void publish(std::vector<ScannedSong> &&batch);
+
+    std::thread worker;
+    std::atomic<bool> stopping{false}; // set on destruction; aborts the scan and the sync
+    std::mutex mutex;
+    LibraryUpdate pending;
+};
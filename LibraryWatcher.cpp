@@ -0,0 +1,200 @@
+#include "LibraryWatcher.h"
+#include <SDL2/SDL.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+static constexpr uint32_t WATCH_MASK = IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE;
+
+LibraryWatcher::~LibraryWatcher() {
+    if (worker.joinable()) {
+        uint64_t one = 1;
+        (void) write(stopFd, &one, sizeof(one));
+        worker.join();
+    }
+    if (inotifyFd >= 0) close(inotifyFd);
+    if (stopFd >= 0) close(stopFd);
+    for (auto &scanned : pending.songs)
+        if (scanned.artwork) SDL_FreeSurface(scanned.artwork);
+}
+
+bool LibraryWatcher::start(const std::string &musicDir) {
+    dir = musicDir;
+    inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    stopFd = eventfd(0, EFD_CLOEXEC);
+    if (inotifyFd < 0 || stopFd < 0) {
+        SDL_Log("Library watcher disabled: inotify unavailable");
+        return false;
+    }
+
+    // IN_CREATE only so an artwork folder made later can be watched too
+    musicWatch = inotify_add_watch(inotifyFd, dir.c_str(), WATCH_MASK | IN_CREATE);
+    watchArtwork();
+    if (musicWatch < 0) {
+        SDL_Log("Library watcher disabled: cannot watch %s", dir.c_str());
+        return false;
+    }
+
+    worker = std::thread(&LibraryWatcher::watchLoop, this);
+    return true;
+}
+
+bool LibraryWatcher::poll(LibraryUpdate &out) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (pending.empty()) return false;
+    for (auto &scanned : pending.songs) out.songs.push_back(std::move(scanned));
+    for (auto &path : pending.removed) out.removed.push_back(std::move(path));
+    pending.songs.clear();
+    pending.removed.clear();
+    return true;
+}
+
+void LibraryWatcher::claimScan(LibraryUpdate &scan) {
+    // No disk access here, this runs on the render thread. A file deleted after
+    // the scan read it either is in `touched` already or has its removal still
+    // being debounced, and that removal is then applied after this scan entry.
+    std::lock_guard<std::mutex> lock(mutex);
+    auto &songs = scan.songs;
+    songs.erase(std::remove_if(songs.begin(), songs.end(), [&](ScannedSong &s) {
+        const std::string &path = s.song.filePath;
+        if (fs::path(path).parent_path() != dir) return false; // remote, the watcher never sees it
+        if (touched.count(path)) {
+            if (s.artwork) SDL_FreeSurface(s.artwork);
+            return true;
+        }
+        known.insert(path);
+        return false;
+    }), songs.end());
+}
+
+void LibraryWatcher::watchLoop() {
+    while (true) {
+        int timeout = -1;
+        if (!dirty.empty()) {
+            auto due = std::min(lastDirty + QUIET_PERIOD, firstDirty + MAX_DELAY);
+            auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(due - Clock::now()).count();
+            timeout = (int) std::max<long long>(0, wait);
+        }
+
+        pollfd fds[2] = {{inotifyFd, POLLIN, 0}, {stopFd, POLLIN, 0}};
+        int ready = ::poll(fds, 2, timeout);
+        if (ready < 0 && errno != EINTR) return;
+        if (fds[1].revents & POLLIN) return;
+        if (fds[0].revents & POLLIN) readEvents();
+
+        if (!dirty.empty()) {
+            auto now = Clock::now();
+            if (now >= lastDirty + QUIET_PERIOD || now >= firstDirty + MAX_DELAY) flush();
+        }
+    }
+}
+
+void LibraryWatcher::watchArtwork() {
+    artworkWatch = inotify_add_watch(inotifyFd, (dir / "artwork").c_str(), WATCH_MASK);
+}
+
+void LibraryWatcher::markDirty(const fs::path &path) {
+    auto now = Clock::now();
+    if (dirty.empty()) firstDirty = now;
+    lastDirty = now;
+    dirty.insert(path.string());
+}
+
+void LibraryWatcher::markArtworkSong(const fs::path &art) {
+    fs::path song = dir / art.stem();
+    song += ".mp3";
+    std::error_code ec;
+    if (fs::exists(song, ec)) markDirty(song);
+}
+
+void LibraryWatcher::readEvents() {
+    alignas(inotify_event) char buf[4096];
+    ssize_t len;
+    while ((len = read(inotifyFd, buf, sizeof(buf))) > 0) {
+        for (char *p = buf; p < buf + len;) {
+            auto *event = reinterpret_cast<inotify_event *>(p);
+            p += sizeof(inotify_event) + event->len;
+
+            if (event->mask & IN_Q_OVERFLOW) {
+                // Events were lost; re-read every file once things settle. Files
+                // we knew about are re-checked too, so lost deletions turn up.
+                std::error_code ec;
+                for (const auto &entry : fs::directory_iterator(dir, ec))
+                    if (isSongFile(entry.path())) markDirty(entry.path());
+                if (artworkWatch < 0) watchArtwork();
+                std::lock_guard<std::mutex> lock(mutex);
+                for (const auto &path : known) markDirty(path);
+                continue;
+            }
+            if (event->wd == artworkWatch && (event->mask & IN_IGNORED)) {
+                artworkWatch = -1; // folder removed; re-added if it comes back
+                continue;
+            }
+            if (!event->len) continue;
+
+            fs::path name = event->name;
+            if (event->mask & IN_ISDIR) {
+                if (event->wd == musicWatch && name == "artwork" && artworkWatch < 0) {
+                    // Art copied in before the watch was added raised no events
+                    watchArtwork();
+                    std::error_code ec;
+                    for (const auto &entry : fs::directory_iterator(dir / name, ec))
+                        if (entry.path().extension() == ".png") markArtworkSong(entry.path());
+                }
+                continue;
+            }
+            if (event->mask & IN_CREATE) continue; // files are read once written
+
+            if (event->wd == musicWatch && isSongFile(name)) {
+                markDirty(dir / name);
+            } else if (event->wd == artworkWatch && name.extension() == ".png") {
+                // New cover art: re-read the song it belongs to
+                markArtworkSong(name);
+            }
+        }
+    }
+}
+
+void LibraryWatcher::flush() {
+    // A file that was created and deleted within one burst is simply gone; one
+    // that was written five times is parsed once.
+    LibraryUpdate batch;
+    for (const auto &path : dirty) {
+        std::error_code ec;
+        if (fs::exists(path, ec)) batch.songs.push_back(scanSongFile(path));
+        else batch.removed.push_back(path);
+    }
+    dirty.clear();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto &scanned : batch.songs) {
+        touched.insert(scanned.song.filePath);
+        known.insert(scanned.song.filePath);
+    }
+    for (auto &path : batch.removed) {
+        touched.insert(path);
+        known.erase(path);
+    }
+
+    // Only the latest state of a path counts if the render thread has not caught up yet
+    for (auto &scanned : batch.songs) {
+        auto &removed = pending.removed;
+        removed.erase(std::remove(removed.begin(), removed.end(), scanned.song.filePath), removed.end());
+        pending.songs.push_back(std::move(scanned));
+    }
+    for (auto &path : batch.removed) {
+        auto &songs = pending.songs;
+        songs.erase(std::remove_if(songs.begin(), songs.end(), [&](ScannedSong &s) {
+            if (s.song.filePath != path) return false;
+            if (s.artwork) SDL_FreeSurface(s.artwork);
+            return true;
+        }), songs.end());
+        pending.removed.push_back(path);
+    }
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include <chrono>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include "Library.h"
+
+// Watches the music folder with inotify and re-reads only the files that
+// changed. Bursts of events (an album being copied in) are coalesced: a file
+// is parsed once the folder has been quiet for a moment, however many events
+// it produced.
+class LibraryWatcher {
+public:
+    ~LibraryWatcher();
+
+    // Starts watching `dir` and its artwork subfolder, which may be created
+    // later. Returns false if inotify is unavailable.
+    bool start(const std::string &dir);
+
+    // Moves finished changes into `out`. Returns false if there was nothing new.
+    bool poll(LibraryUpdate &out);
+
+    // Watching starts before the initial scan, so the scan can finish after the
+    // watcher has already reported a newer state of a file. Drops such stale
+    // entries from `scan`, and remembers the rest so deletions lost to an event
+    // queue overflow can still be found.
+    void claimScan(LibraryUpdate &scan);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    // Wait this long after the last event before parsing...
+    static constexpr std::chrono::milliseconds QUIET_PERIOD{750};
+    // ...but never hold changes back for longer than this during a long copy.
+    static constexpr std::chrono::milliseconds MAX_DELAY{5000};
+
+    void watchLoop();
+    void readEvents();
+    void watchArtwork();
+    void markDirty(const std::filesystem::path &path);
+    void markArtworkSong(const std::filesystem::path &art);
+    void flush();
+
+    std::filesystem::path dir;
+    int inotifyFd = -1;
+    int stopFd = -1;
+    int musicWatch = -1;
+    int artworkWatch = -1;
+    std::thread worker;
+
+    // Worker thread only
+    std::unordered_set<std::string> dirty;
+    Clock::time_point firstDirty;
+    Clock::time_point lastDirty;
+
+    std::mutex mutex;
+    LibraryUpdate pending;
+    std::unordered_set<std::string> touched; // paths reported since start()
+    std::unordered_set<std::string> known;   // paths believed to be in the library
+};
@@ -5,9 +5,11 @@
 #include "../AppState.h"
 #include "../Song.h"
 
-std::vector<Song> loadSongs(SDL_Renderer *renderer);
-
 void drawSongsMenu(SDL_Renderer *renderer, TTF_Font *font, AppState &state, const std::vector<Song> &songs,
                    int winWidth, int winHeight);
 
+// Lists songs[rows[0]] .. songs[rows[count - 1]], e.g. the contents of a playlist.
+void drawSongsMenu(SDL_Renderer *renderer, TTF_Font *font, AppState &state, const std::vector<Song> &songs,
+                   const std::vector<int> &rows, int count, int winWidth, int winHeight);
+
 void drawMusicScreen(SDL_Renderer *renderer, TTF_Font *font, const Song *currentSong, int winWidth, int winHeight);
@@ -0,0 +1,116 @@
+#include "PhotosPage.h"
+#include "../Utils.h"
+#include <algorithm>
+#include <cctype>
+
+namespace fs = std::filesystem;
+
+constexpr int GRID_COLUMNS = 4;
+constexpr int TOP_BAR_HEIGHT = 20;
+
+void PhotosPage::refresh() {
+    photos.clear();
+    std::error_code ec;
+    for (const auto &entry : fs::directory_iterator("assets/photos", ec)) {
+        std::string ext = entry.path().extension().string();
+        std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+        if (ext == ".jpg" || ext == ".jpeg" || ext == ".png")
+            photos.push_back(entry.path());
+    }
+    std::sort(photos.begin(), photos.end());
+    cache.reset(photos);
+    viewing = false;
+}
+
+void PhotosPage::closeViewer() {
+    viewing = false;
+    cache.dropImages();
+}
+
+int PhotosPage::above(int index) const {
+    if (viewing) return (index - 1 + count()) % count();
+    return index >= GRID_COLUMNS ? index - GRID_COLUMNS : index;
+}
+
+int PhotosPage::below(int index) const {
+    if (viewing) return (index + 1) % count();
+    if (index + GRID_COLUMNS < count()) return index + GRID_COLUMNS;
+    // Partial last row: land on its last photo rather than not moving
+    bool lastRow = index / GRID_COLUMNS == (count() - 1) / GRID_COLUMNS;
+    return lastRow ? index : count() - 1;
+}
+
+void PhotosPage::unload() {
+    photos.clear();
+    cache.reset(photos);
+    viewing = false;
+}
+
+// Draws `tex` as large as fits inside `box`, centered.
+static void drawFitted(SDL_Renderer *r, SDL_Texture *tex, const SDL_Rect &box) {
+    int w, h;
+    SDL_QueryTexture(tex, nullptr, nullptr, &w, &h);
+    float scale = std::min(box.w / float(w), box.h / float(h));
+    int dw = int(w * scale);
+    int dh = int(h * scale);
+    SDL_Rect dst{box.x + (box.w - dw) / 2, box.y + (box.h - dh) / 2, dw, dh};
+    SDL_RenderCopy(r, tex, nullptr, &dst);
+}
+
+void PhotosPage::draw(SDL_Renderer *r, TTF_Font *font, AppState &state, int winWidth, int winHeight) {
+    cache.upload(r);
+    if (viewing) drawViewer(r, state, winWidth, winHeight);
+    else drawGrid(r, font, state, winWidth, winHeight);
+}
+
+void PhotosPage::drawGrid(SDL_Renderer *r, TTF_Font *font, AppState &state, int winWidth, int winHeight) {
+    if (photos.empty()) {
+        drawTopBar(r, font, "Photos", winWidth);
+        SDL_Texture *t = renderText(r, font, "No photos", {120, 120, 120, 255});
+        int w, h;
+        SDL_QueryTexture(t, nullptr, nullptr, &w, &h);
+        SDL_Rect dst{(winWidth - w) / 2, (winHeight - h) / 2, w, h};
+        SDL_RenderCopy(r, t, nullptr, &dst);
+        SDL_DestroyTexture(t);
+        return;
+    }
+
+    int cell = winWidth / GRID_COLUMNS;
+    int centerY = (winHeight + TOP_BAR_HEIGHT) / 2 - cell / 2;
+    state.visualOffset += (state.selected / GRID_COLUMNS - state.visualOffset) * 0.15f;
+
+    for (int i = 0; i < (int) photos.size(); ++i) {
+        float y = centerY + (i / GRID_COLUMNS - state.visualOffset) * cell;
+        if (y < TOP_BAR_HEIGHT - cell || y > winHeight) continue;
+
+        SDL_Rect box{(i % GRID_COLUMNS) * cell + 3, (int) y + 3, cell - 6, cell - 6};
+        if (SDL_Texture *thumb = cache.thumbnail(i)) {
+            drawFitted(r, thumb, box);
+        } else {
+            SDL_SetRenderDrawColor(r, 210, 210, 210, 255);
+            SDL_RenderFillRect(r, &box);
+        }
+
+        if (i == state.selected) {
+            SDL_SetRenderDrawColor(r, 20, 120, 255, 255);
+            for (int t = 0; t < 3; t++) {
+                SDL_Rect outline{box.x - t, box.y - t, box.w + 2 * t, box.h + 2 * t};
+                SDL_RenderDrawRect(r, &outline);
+            }
+        }
+    }
+
+    // Drawn last so rows scroll underneath it
+    drawTopBar(r, font, "Photos", winWidth);
+}
+
+void PhotosPage::drawViewer(SDL_Renderer *r, AppState &state, int winWidth, int winHeight) {
+    SDL_SetRenderDrawColor(r, 0, 0, 0, 255);
+    SDL_Rect screen{0, 0, winWidth, winHeight};
+    SDL_RenderFillRect(r, &screen);
+
+    // Until the display-sized decode lands, show the thumbnail scaled up
+    SDL_Texture *tex = cache.image(state.selected, winWidth, winHeight);
+    if (!tex) tex = cache.thumbnail(state.selected);
+    if (tex) drawFitted(r, tex, screen);
+}
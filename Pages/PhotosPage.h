@@ -0,0 +1,37 @@
+#pragma once
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+#include <filesystem>
+#include <vector>
+#include "../AppState.h"
+#include "../PhotoCache.h"
+
+// Thumbnail grid over assets/photos with a full-screen viewer.
+class PhotosPage {
+public:
+    // Rescans assets/photos. Called each time the page is opened.
+    void refresh();
+    int count() const { return (int) photos.size(); }
+
+    void view() { viewing = !photos.empty(); }
+    void closeViewer();
+    bool isViewing() const { return viewing; }
+
+    // Up/Down targets from `index`: a grid row away, or the previous/next
+    // photo while viewing. The grid stops at its edges; the viewer wraps.
+    int above(int index) const;
+    int below(int index) const;
+
+    // Frees every texture; call before the renderer is destroyed.
+    void unload();
+
+    void draw(SDL_Renderer *r, TTF_Font *font, AppState &state, int winWidth, int winHeight);
+
+private:
+    void drawGrid(SDL_Renderer *r, TTF_Font *font, AppState &state, int winWidth, int winHeight);
+    void drawViewer(SDL_Renderer *r, AppState &state, int winWidth, int winHeight);
+
+    std::vector<std::filesystem::path> photos;
+    PhotoCache cache;
+    bool viewing = false;
+};
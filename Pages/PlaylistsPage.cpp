@@ -0,0 +1,43 @@
+#include "PlaylistsPage.h"
+#include "MusicPage.h"
+#include "../Utils.h"
+#include <string>
+
+constexpr int ITEM_HEIGHT = 36;
+
+void drawPlaylistsPage(SDL_Renderer *r, TTF_Font *font, AppState &state, const SmartPlaylists &playlists,
+                       const std::vector<Song> &songs, int winWidth, int winHeight) {
+    if (state.openPlaylist >= 0 && state.openPlaylist < playlists.count()) {
+        drawSongsMenu(r, font, state, songs, playlists.rows(state.openPlaylist),
+                      playlists.size(state.openPlaylist), winWidth, winHeight);
+        drawTopBar(r, font, playlists.name(state.openPlaylist), winWidth);
+        return;
+    }
+
+    drawTopBar(r, font, "Playlists", winWidth);
+    int centerY = (winHeight + 32) / 2;
+    state.visualOffset += (state.selected - state.visualOffset) * 0.15f;
+
+    for (int i = 0; i < playlists.count(); ++i) {
+        float y = centerY + (i - state.visualOffset) * ITEM_HEIGHT;
+        if (y < 32 - ITEM_HEIGHT || y > winHeight + ITEM_HEIGHT) continue;
+
+        bool selected = (i == state.selected);
+        if (selected) drawHighlight(r, SDL_Rect{0, (int) y - 4, winWidth, ITEM_HEIGHT});
+
+        SDL_Color color = selected ? SDL_Color{255, 255, 255, 255} : SDL_Color{40, 40, 40, 255};
+        SDL_Texture *text = renderText(r, font, playlists.name(i), color);
+        int w, h;
+        SDL_QueryTexture(text, nullptr, nullptr, &w, &h);
+        SDL_Rect dst{24, (int) y, w, h};
+        SDL_RenderCopy(r, text, nullptr, &dst);
+        SDL_DestroyTexture(text);
+
+        SDL_Texture *countTex = renderText(r, font, std::to_string(playlists.size(i)),
+                                           selected ? color : SDL_Color{120, 120, 120, 255});
+        SDL_QueryTexture(countTex, nullptr, nullptr, &w, &h);
+        SDL_Rect countDst{winWidth - w - 12, (int) y, w, h};
+        SDL_RenderCopy(r, countTex, nullptr, &countDst);
+        SDL_DestroyTexture(countTex);
+    }
+}
@@ -0,0 +1,11 @@
+#pragma once
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+#include <vector>
+#include "../AppState.h"
+#include "../SmartPlaylists.h"
+#include "../Song.h"
+
+// Lists the smart playlists, or the songs of `state.openPlaylist`.
+void drawPlaylistsPage(SDL_Renderer *r, TTF_Font *font, AppState &state, const SmartPlaylists &playlists,
+                       const std::vector<Song> &songs, int winWidth, int winHeight);
@@ -17,6 +17,7 @@ void drawSettingsPage(SDL_Renderer *r, TTF_Font *font, AppState &state, int winW
         "Shuffle: Off",
         "Repeat: Off",
         "Add Jellyfin Server",
+        std::string("Verify Jellyfin TLS: ") + (state.jellyfinVerifyTls ? "On" : "Off"),
         "Reset PiPod OS"
     };
     int topY = 32 + 24; // below top bar
@@ -2,4 +2,71 @@
 // Created by Matti Kjellstadli on 16/12/2025.
 //
 
-#include "VideoPage.h"
\ No newline at end of file
+#include "VideoPage.h"
+#include "../Utils.h"
+#include <algorithm>
+
+namespace fs = std::filesystem;
+
+constexpr int ITEM_HEIGHT = 36;
+
+void VideoPage::refresh() {
+    videos.clear();
+    std::error_code ec;
+    for (const auto &entry : fs::directory_iterator("assets/videos", ec)) {
+        std::string ext = entry.path().extension().string();
+        if (ext == ".mp4" || ext == ".mkv" || ext == ".webm" || ext == ".avi" || ext == ".mov")
+            videos.push_back(entry.path());
+    }
+    std::sort(videos.begin(), videos.end());
+}
+
+void VideoPage::play(int index) {
+    if (index < 0 || index >= (int) videos.size()) return;
+    player.open(videos[index].string());
+}
+
+void VideoPage::stop() {
+    player.close();
+}
+
+void VideoPage::draw(SDL_Renderer *r, TTF_Font *font, AppState &state, int winWidth, int winHeight) {
+    if (player.isOpen()) {
+        if (player.ended()) player.close();
+        else {
+            player.present(r, winWidth, winHeight);
+            return;
+        }
+    }
+
+    drawTopBar(r, font, "Videos", winWidth);
+
+    if (videos.empty()) {
+        SDL_Texture *t = renderText(r, font, "No videos", {120, 120, 120, 255});
+        int w, h;
+        SDL_QueryTexture(t, nullptr, nullptr, &w, &h);
+        SDL_Rect dst{(winWidth - w) / 2, (winHeight - h) / 2, w, h};
+        SDL_RenderCopy(r, t, nullptr, &dst);
+        SDL_DestroyTexture(t);
+        return;
+    }
+
+    int centerY = (winHeight + 32) / 2;
+    state.visualOffset += (state.selected - state.visualOffset) * 0.15f;
+
+    for (int i = 0; i < (int) videos.size(); ++i) {
+        float y = centerY + (i - state.visualOffset) * ITEM_HEIGHT;
+        if (y < 32 - ITEM_HEIGHT || y > winHeight + ITEM_HEIGHT) continue;
+
+        bool selected = (i == state.selected);
+        if (selected) drawHighlight(r, SDL_Rect{0, (int) y - 4, winWidth, ITEM_HEIGHT});
+
+        SDL_Color color = selected ? SDL_Color{255, 255, 255, 255} : SDL_Color{40, 40, 40, 255};
+        SDL_Texture *text = renderText(r, font, videos[i].stem().string(), color);
+        int w, h;
+        SDL_QueryTexture(text, nullptr, nullptr, &w, &h);
+        SDL_Rect dst{24, (int) y, w, h};
+        SDL_RenderCopy(r, text, nullptr, &dst);
+        SDL_DestroyTexture(text);
+    }
+}
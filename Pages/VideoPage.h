@@ -5,9 +5,30 @@
 #ifndef MYOS_VIDEOPAGE_H
 #define MYOS_VIDEOPAGE_H
 
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+#include <filesystem>
+#include <vector>
+#include "../AppState.h"
+#include "../VideoPlayer.h"
 
+// Lists the files in assets/videos and plays the selected one full screen.
 class VideoPage {
+public:
+    // Rescans assets/videos. Called each time the page is opened.
+    void refresh();
+    int count() const { return (int) videos.size(); }
+
+    void play(int index);
+    void stop();
+    bool isPlaying() const { return player.isOpen(); }
+
+    void draw(SDL_Renderer *r, TTF_Font *font, AppState &state, int winWidth, int winHeight);
+
+private:
+    std::vector<std::filesystem::path> videos;
+    VideoPlayer player;
 };
 
 
-#endif //MYOS_VIDEOPAGE_H
\ No newline at end of file
+#endif //MYOS_VIDEOPAGE_H
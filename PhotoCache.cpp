@@ -0,0 +1,450 @@
+#include "PhotoCache.h"
+#include <SDL2/SDL_image.h>
+#include <algorithm>
+#include <cctype>
+#include <csetjmp>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <sstream>
+#include <jpeglib.h>
+
+namespace fs = std::filesystem;
+
+static const fs::path THUMB_CACHE_DIR = "cache/thumbs";
+
+// ------------------ DECODING ------------------
+
+struct JpegError {
+    jpeg_error_mgr mgr;
+    jmp_buf jump;
+};
+
+// libjpeg's default handler calls exit(); jump back to the caller instead
+static void jpegErrorExit(j_common_ptr cinfo) {
+    longjmp(reinterpret_cast<JpegError *>(cinfo->err)->jump, 1);
+}
+
+// EXIF orientation (1-8) from the APP1 marker saved during jpeg_read_header,
+// or 1 if the file carries none. Only IFD0 is searched, where cameras put it.
+static int exifOrientation(const jpeg_decompress_struct &cinfo) {
+    for (jpeg_saved_marker_ptr m = cinfo.marker_list; m; m = m->next) {
+        if (m->marker != JPEG_APP0 + 1 || m->data_length < 14) continue;
+        const unsigned char *data = m->data;
+        if (std::memcmp(data, "Exif\0\0", 6) != 0) continue;
+
+        const unsigned char *tiff = data + 6;
+        size_t size = m->data_length - 6;
+        bool little = tiff[0] == 'I' && tiff[1] == 'I';
+        if (!little && !(tiff[0] == 'M' && tiff[1] == 'M')) return 1;
+        auto read16 = [&](size_t at) {
+            return little ? tiff[at] | tiff[at + 1] << 8 : tiff[at] << 8 | tiff[at + 1];
+        };
+        auto read32 = [&](size_t at) {
+            return little ? uint32_t(read16(at)) | uint32_t(read16(at + 2)) << 16
+                          : uint32_t(read16(at)) << 16 | uint32_t(read16(at + 2));
+        };
+
+        size_t ifd = read32(4);
+        if (ifd + 2 > size) return 1;
+        int entries = read16(ifd);
+        for (int i = 0; i < entries; i++) {
+            size_t entry = ifd + 2 + i * 12;
+            if (entry + 12 > size) break;
+            if (read16(entry) == 0x0112) {
+                int value = read16(entry + 8);
+                return value >= 1 && value <= 8 ? value : 1;
+            }
+        }
+        return 1;
+    }
+    return 1;
+}
+
+// Rotates/flips an RGB24 surface from stored to display orientation.
+// Orientations 5-8 swap width and height.
+static SDL_Surface *applyOrientation(SDL_Surface *src, int orientation) {
+    if (orientation <= 1) return src;
+    int w = src->w, h = src->h;
+    bool swap = orientation >= 5;
+    SDL_Surface *dst = SDL_CreateRGBSurfaceWithFormat(0, swap ? h : w, swap ? w : h, 24, SDL_PIXELFORMAT_RGB24);
+    if (!dst) return src;
+
+    for (int y = 0; y < dst->h; y++) {
+        Uint8 *out = static_cast<Uint8 *>(dst->pixels) + y * dst->pitch;
+        for (int x = 0; x < dst->w; x++) {
+            int sx, sy;
+            switch (orientation) {
+                case 2: sx = w - 1 - x; sy = y; break;         // mirrored
+                case 3: sx = w - 1 - x; sy = h - 1 - y; break; // upside down
+                case 4: sx = x; sy = h - 1 - y; break;         // flipped
+                case 5: sx = y; sy = x; break;                 // transposed
+                case 6: sx = y; sy = h - 1 - x; break;         // needs 90° clockwise
+                case 7: sx = w - 1 - y; sy = h - 1 - x; break; // transversed
+                default: sx = w - 1 - y; sy = x; break;        // 8: needs 90° counter-clockwise
+            }
+            const Uint8 *in = static_cast<const Uint8 *>(src->pixels) + sy * src->pitch + sx * 3;
+            out[x * 3] = in[0];
+            out[x * 3 + 1] = in[1];
+            out[x * 3 + 2] = in[2];
+        }
+    }
+    SDL_FreeSurface(src);
+    return dst;
+}
+
+// Decodes with the largest DCT scale (1/8, 1/4, 1/2) that still leaves the
+// image at least as big as maxW x maxH, so only that size is ever allocated.
+// The result is turned upright according to the EXIF orientation tag.
+static SDL_Surface *decodeJpeg(const char *path, int maxW, int maxH) {
+    FILE *file = std::fopen(path, "rb");
+    if (!file) return nullptr;
+
+    jpeg_decompress_struct cinfo;
+    JpegError err;
+    SDL_Surface *volatile surface = nullptr;
+    cinfo.err = jpeg_std_error(&err.mgr);
+    err.mgr.error_exit = jpegErrorExit;
+    if (setjmp(err.jump)) {
+        jpeg_destroy_decompress(&cinfo);
+        std::fclose(file);
+        if (surface) SDL_FreeSurface(surface);
+        return nullptr;
+    }
+
+    jpeg_create_decompress(&cinfo);
+    jpeg_stdio_src(&cinfo, file);
+    jpeg_save_markers(&cinfo, JPEG_APP0 + 1, 0xFFFF);
+    jpeg_read_header(&cinfo, TRUE);
+
+    int orientation = exifOrientation(cinfo);
+    // Fit against the upright size: sideways photos are rotated after decoding
+    float uprightW = float(orientation >= 5 ? cinfo.image_height : cinfo.image_width);
+    float uprightH = float(orientation >= 5 ? cinfo.image_width : cinfo.image_height);
+    float fit = std::min(maxW / uprightW, maxH / uprightH);
+    unsigned denom = 8;
+    while (denom > 1 && fit * denom > 1.0f) denom /= 2;
+    cinfo.scale_num = 1;
+    cinfo.scale_denom = denom;
+    cinfo.out_color_space = JCS_RGB;
+    cinfo.dct_method = JDCT_IFAST;
+    cinfo.do_fancy_upsampling = FALSE;
+
+    jpeg_start_decompress(&cinfo);
+    surface = SDL_CreateRGBSurfaceWithFormat(0, cinfo.output_width, cinfo.output_height, 24, SDL_PIXELFORMAT_RGB24);
+    if (!surface) longjmp(err.jump, 1);
+    while (cinfo.output_scanline < cinfo.output_height) {
+        JSAMPROW row = static_cast<JSAMPROW>(surface->pixels) + cinfo.output_scanline * surface->pitch;
+        jpeg_read_scanlines(&cinfo, &row, 1);
+    }
+    jpeg_finish_decompress(&cinfo);
+    jpeg_destroy_decompress(&cinfo);
+    std::fclose(file);
+    return applyOrientation(surface, orientation);
+}
+
+static bool saveJpeg(SDL_Surface *surface, const char *path) {
+    FILE *file = std::fopen(path, "wb");
+    if (!file) return false;
+
+    jpeg_compress_struct cinfo;
+    JpegError err;
+    cinfo.err = jpeg_std_error(&err.mgr);
+    err.mgr.error_exit = jpegErrorExit;
+    if (setjmp(err.jump)) {
+        jpeg_destroy_compress(&cinfo);
+        std::fclose(file);
+        return false;
+    }
+
+    jpeg_create_compress(&cinfo);
+    jpeg_stdio_dest(&cinfo, file);
+    cinfo.image_width = surface->w;
+    cinfo.image_height = surface->h;
+    cinfo.input_components = 3;
+    cinfo.in_color_space = JCS_RGB;
+    jpeg_set_defaults(&cinfo);
+    jpeg_set_quality(&cinfo, 85, TRUE);
+    jpeg_start_compress(&cinfo, TRUE);
+    while (cinfo.next_scanline < cinfo.image_height) {
+        JSAMPROW row = static_cast<JSAMPROW>(surface->pixels) + cinfo.next_scanline * surface->pitch;
+        jpeg_write_scanlines(&cinfo, &row, 1);
+    }
+    jpeg_finish_compress(&cinfo);
+    jpeg_destroy_compress(&cinfo);
+    return std::fclose(file) == 0;
+}
+
+// Box-filters an RGB24 surface down to fit maxW x maxH. Takes ownership of `src`.
+static SDL_Surface *shrinkToFit(SDL_Surface *src, int maxW, int maxH) {
+    float scale = std::min(maxW / float(src->w), maxH / float(src->h));
+    if (scale >= 1.0f) return src;
+
+    int w = std::max(1, int(src->w * scale));
+    int h = std::max(1, int(src->h * scale));
+    SDL_Surface *dst = SDL_CreateRGBSurfaceWithFormat(0, w, h, 24, SDL_PIXELFORMAT_RGB24);
+    if (!dst) return src;
+
+    const Uint8 *in = static_cast<const Uint8 *>(src->pixels);
+    Uint8 *out = static_cast<Uint8 *>(dst->pixels);
+    for (int y = 0; y < h; y++) {
+        int sy0 = y * src->h / h;
+        int sy1 = std::max(sy0 + 1, (y + 1) * src->h / h);
+        for (int x = 0; x < w; x++) {
+            int sx0 = x * src->w / w;
+            int sx1 = std::max(sx0 + 1, (x + 1) * src->w / w);
+            unsigned sum[3] = {0, 0, 0};
+            for (int sy = sy0; sy < sy1; sy++) {
+                const Uint8 *p = in + sy * src->pitch + sx0 * 3;
+                for (int sx = sx0; sx < sx1; sx++, p += 3) {
+                    sum[0] += p[0];
+                    sum[1] += p[1];
+                    sum[2] += p[2];
+                }
+            }
+            unsigned n = (sy1 - sy0) * (sx1 - sx0);
+            Uint8 *q = out + y * dst->pitch + x * 3;
+            q[0] = Uint8(sum[0] / n);
+            q[1] = Uint8(sum[1] / n);
+            q[2] = Uint8(sum[2] / n);
+        }
+    }
+    SDL_FreeSurface(src);
+    return dst;
+}
+
+static SDL_Surface *decodeImage(const fs::path &path, int maxW, int maxH) {
+    std::string ext = path.extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+
+    SDL_Surface *surface = nullptr;
+    if (ext == ".jpg" || ext == ".jpeg") {
+        surface = decodeJpeg(path.c_str(), maxW, maxH);
+    } else {
+        // Other formats have no scaled decode; convert to RGB24 so shrinkToFit can read them
+        SDL_Surface *loaded = IMG_Load(path.c_str());
+        if (loaded) {
+            surface = SDL_ConvertSurfaceFormat(loaded, SDL_PIXELFORMAT_RGB24, 0);
+            SDL_FreeSurface(loaded);
+        }
+    }
+    return surface ? shrinkToFit(surface, maxW, maxH) : nullptr;
+}
+
+// Cache file name for `path`; changes whenever the photo is edited. The "-o"
+// suffix marks thumbnails stored upright, so older sideways ones get pruned.
+static std::string thumbnailName(const fs::path &path) {
+    std::error_code ec;
+    auto stamp = fs::last_write_time(path, ec).time_since_epoch().count();
+    std::ostringstream name;
+    name << std::hex << std::hash<std::string>{}(path.string()) << "-" << stamp << "-o.jpg";
+    return name.str();
+}
+
+static SDL_Surface *loadThumbnail(const fs::path &path, int size) {
+    std::error_code ec;
+    fs::path cached = THUMB_CACHE_DIR / thumbnailName(path);
+
+    if (fs::exists(cached, ec)) {
+        if (SDL_Surface *surface = decodeJpeg(cached.c_str(), size, size)) return surface;
+    }
+
+    SDL_Surface *surface = decodeImage(path, size, size);
+    if (surface) {
+        fs::create_directories(THUMB_CACHE_DIR, ec);
+        fs::path tmp = cached;
+        tmp += ".tmp";
+        if (saveJpeg(surface, tmp.c_str())) fs::rename(tmp, cached, ec);
+        else fs::remove(tmp, ec);
+    }
+    return surface;
+}
+
+// Deletes cached thumbnails of photos that were edited or removed since they were made.
+static void pruneThumbnails(const std::vector<fs::path> &photos) {
+    std::unordered_set<std::string> current;
+    for (const auto &photo : photos) current.insert(thumbnailName(photo));
+
+    std::error_code ec;
+    for (const auto &entry : fs::directory_iterator(THUMB_CACHE_DIR, ec)) {
+        if (!current.count(entry.path().filename().string())) fs::remove(entry.path(), ec);
+    }
+}
+
+// ------------------ CACHE ------------------
+
+PhotoCache::PhotoCache() {
+    worker = std::thread(&PhotoCache::workLoop, this);
+}
+
+PhotoCache::~PhotoCache() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    cv.notify_all();
+    worker.join();
+    for (auto &result : results)
+        if (result.surface) SDL_FreeSurface(result.surface);
+    clearTextures();
+}
+
+std::string PhotoCache::jobKey(Kind kind, const std::string &path) {
+    return (kind == Kind::Full ? "F:" : "T:") + path;
+}
+
+void PhotoCache::reset(const std::vector<fs::path> &newPhotos) {
+    photos = newPhotos;
+    generation++;
+    clearTextures();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    imageJobs.clear();
+    thumbJobs.clear();
+    pending.clear();
+    // An empty list means the page was unloaded, not that every photo is gone
+    if (!photos.empty()) pruneList = photos;
+    cv.notify_all();
+}
+
+void PhotoCache::clearTextures() {
+    for (auto &[path, thumb] : thumbs) SDL_DestroyTexture(thumb.texture);
+    thumbs.clear();
+    dropImages();
+}
+
+void PhotoCache::dropImages() {
+    for (auto &[path, texture] : images) SDL_DestroyTexture(texture);
+    images.clear();
+    wantedImages.clear();
+}
+
+SDL_Texture *PhotoCache::thumbnail(int index) {
+    if (index < 0 || index >= (int) photos.size()) return nullptr;
+    const std::string path = photos[index].string();
+
+    auto found = thumbs.find(path);
+    if (found != thumbs.end()) {
+        found->second.lastUsed = frame;
+        return found->second.texture;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (pending.insert(jobKey(Kind::Thumbnail, path)).second) {
+        thumbJobs.push_front({Kind::Thumbnail, path, THUMB_SIZE, THUMB_SIZE, generation});
+        // Scrolled far past? Forget the oldest requests rather than decode them
+        while (thumbJobs.size() > THUMB_QUEUE_LIMIT) {
+            pending.erase(jobKey(Kind::Thumbnail, thumbJobs.back().path));
+            thumbJobs.pop_back();
+        }
+        cv.notify_one();
+    }
+    return nullptr;
+}
+
+SDL_Texture *PhotoCache::image(int index, int displayW, int displayH) {
+    if (index < 0 || index >= (int) photos.size()) return nullptr;
+    int count = (int) photos.size();
+
+    // The viewed photo first, then the ones a swipe away
+    std::vector<std::string> wanted{
+        photos[index].string(),
+        photos[(index + 1) % count].string(),
+        photos[(index - 1 + count) % count].string()
+    };
+
+    std::unordered_set<std::string> wantedSet(wanted.begin(), wanted.end());
+    if (wantedSet != wantedImages) {
+        wantedImages = std::move(wantedSet);
+        for (auto it = images.begin(); it != images.end();) {
+            if (wantedImages.count(it->first)) ++it;
+            else {
+                SDL_DestroyTexture(it->second);
+                it = images.erase(it);
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto &job : imageJobs) pending.erase(jobKey(Kind::Full, job.path));
+        imageJobs.clear();
+        for (auto &path : wanted) {
+            if (images.count(path)) continue;
+            if (pending.insert(jobKey(Kind::Full, path)).second)
+                imageJobs.push_back({Kind::Full, path, displayW, displayH, generation});
+        }
+        cv.notify_one();
+    }
+
+    auto found = images.find(wanted[0]);
+    return found != images.end() ? found->second : nullptr;
+}
+
+void PhotoCache::upload(SDL_Renderer *r) {
+    frame++;
+    std::vector<Result> done;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        done.swap(results);
+        for (auto &result : done)
+            if (result.generation == generation) pending.erase(jobKey(result.kind, result.path));
+    }
+
+    for (auto &result : done) {
+        if (!result.surface) continue;
+        bool keep = result.generation == generation &&
+                    (result.kind == Kind::Thumbnail || wantedImages.count(result.path));
+        SDL_Texture *texture = keep ? SDL_CreateTextureFromSurface(r, result.surface) : nullptr;
+        SDL_FreeSurface(result.surface);
+        if (!texture) continue;
+
+        if (result.kind == Kind::Thumbnail) {
+            thumbs[result.path] = {texture, frame};
+        } else {
+            auto &slot = images[result.path];
+            if (slot) SDL_DestroyTexture(slot);
+            slot = texture;
+        }
+    }
+
+    // Least recently drawn thumbnails go first
+    while (thumbs.size() > THUMB_TEXTURE_LIMIT) {
+        auto oldest = std::min_element(thumbs.begin(), thumbs.end(), [](const auto &a, const auto &b) {
+            return a.second.lastUsed < b.second.lastUsed;
+        });
+        SDL_DestroyTexture(oldest->second.texture);
+        thumbs.erase(oldest);
+    }
+}
+
+void PhotoCache::workLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        cv.wait(lock, [this] {
+            return stopping || !imageJobs.empty() || !thumbJobs.empty() || !pruneList.empty();
+        });
+        if (stopping) return;
+
+        // Housekeeping waits until nothing on screen is waiting for a decode
+        if (imageJobs.empty() && thumbJobs.empty()) {
+            std::vector<fs::path> list;
+            list.swap(pruneList);
+            lock.unlock();
+            pruneThumbnails(list);
+            lock.lock();
+            continue;
+        }
+
+        // The viewer never waits behind the grid
+        Job job = !imageJobs.empty() ? imageJobs.front() : thumbJobs.front();
+        if (!imageJobs.empty()) imageJobs.pop_front();
+        else thumbJobs.pop_front();
+        lock.unlock();
+
+        SDL_Surface *surface = job.kind == Kind::Full
+                                   ? decodeImage(job.path, job.maxW, job.maxH)
+                                   : loadThumbnail(job.path, job.maxW);
+
+        lock.lock();
+        results.push_back({job.kind, job.path, surface, job.generation});
+    }
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include <SDL2/SDL.h>
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Decodes photos on a worker thread and keeps a bounded set of textures.
+//
+// JPEGs are decoded with libjpeg's DCT scaling at the nearest power-of-two
+// size above the target, so a 20 MP file never exists in memory at full size.
+// Thumbnails are also written to cache/thumbs so later visits skip the decode;
+// reset() prunes the ones that no longer match a photo.
+// Full-screen images are only kept for the viewed photo and its neighbours.
+class PhotoCache {
+public:
+    PhotoCache();
+    ~PhotoCache();
+
+    // Switches to a new list of photos and drops everything cached for the old one.
+    void reset(const std::vector<std::filesystem::path> &photos);
+
+    // Returns the thumbnail if it is ready, otherwise queues it and returns nullptr.
+    SDL_Texture *thumbnail(int index);
+
+    // Returns photo `index` decoded to fit the display, or nullptr while it is
+    // still decoding. Prefetches the previous and next photo and evicts the rest.
+    SDL_Texture *image(int index, int displayW, int displayH);
+
+    // Frees the full-screen images, e.g. when the viewer closes.
+    void dropImages();
+
+    // Turns finished decodes into textures. Call once per frame on the render thread.
+    void upload(SDL_Renderer *r);
+
+private:
+    enum class Kind { Thumbnail, Full };
+
+    struct Job {
+        Kind kind;
+        std::string path;
+        int maxW, maxH;
+        unsigned generation;
+    };
+
+    struct Result {
+        Kind kind;
+        std::string path;
+        SDL_Surface *surface;
+        unsigned generation;
+    };
+
+    struct CachedThumbnail {
+        SDL_Texture *texture;
+        uint64_t lastUsed;
+    };
+
+    static constexpr int THUMB_SIZE = 128;
+    static constexpr size_t THUMB_TEXTURE_LIMIT = 120;
+    static constexpr size_t THUMB_QUEUE_LIMIT = 48;
+
+    static std::string jobKey(Kind kind, const std::string &path);
+
+    void workLoop();
+    void clearTextures();
+
+    std::vector<std::filesystem::path> photos;
+    unsigned generation = 0; // bumped by reset() so stale decodes are thrown away
+    uint64_t frame = 0;
+
+    // Render thread only
+    std::unordered_map<std::string, CachedThumbnail> thumbs;
+    std::unordered_map<std::string, SDL_Texture *> images;
+    std::unordered_set<std::string> wantedImages;
+
+    // Shared with the worker
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool stopping = false;
+    std::deque<Job> imageJobs;
+    std::deque<Job> thumbJobs; // newest first, so what is on screen now decodes first
+    std::unordered_set<std::string> pending;
+    std::vector<Result> results;
+    std::vector<std::filesystem::path> pruneList; // photos whose thumbnails are worth keeping
+};
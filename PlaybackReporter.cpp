@@ -0,0 +1,261 @@
+#include "PlaybackReporter.h"
+#include "JellyfinClient.h"
+#include <SDL2/SDL.h>
+#include <algorithm>
+#include <cerrno>
+#include <fcntl.h>
+#include <sstream>
+#include <unistd.h>
+#include <unordered_map>
+
+static const char *LOG_PATH = "playback.wal";
+// A skip produces a stop and a start a moment apart; give them one fsync
+static constexpr auto COMMIT_DELAY = std::chrono::milliseconds(1000);
+static constexpr auto MIN_BACKOFF = std::chrono::seconds(5);
+static constexpr auto MAX_BACKOFF = std::chrono::seconds(300);
+
+static bool writeAll(int fd, const std::string &text) {
+    const char *p = text.data();
+    size_t left = text.size();
+    while (left > 0) {
+        ssize_t n = write(fd, p, left);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p += n;
+        left -= n;
+    }
+    return true;
+}
+
+PlaybackReporter::~PlaybackReporter() {
+    if (worker.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_one();
+        worker.join();
+    }
+    if (logFd >= 0) close(logFd);
+}
+
+void PlaybackReporter::start(Jellyfin::Account &account) {
+    jellyfin = &account;
+    worker = std::thread(&PlaybackReporter::run, this);
+}
+
+void PlaybackReporter::report(Event event, const std::string &itemId, int64_t positionMs) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        incoming.push_back({0, event, positionMs, itemId});
+    }
+    wake.notify_one();
+}
+
+void PlaybackReporter::loginChanged() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        retryNow = true;
+    }
+    wake.notify_one();
+}
+
+void PlaybackReporter::run() {
+    replayLog();
+
+    while (true) {
+        // Asked outside our lock: the account may be busy signing in, and
+        // report() must never wait for that
+        bool sendable = !unsent.empty() && canSend();
+
+        std::vector<Record> batch;
+        bool exiting;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            auto ready = [this] { return stopping || retryNow || !incoming.empty(); };
+            if (sendable) wake.wait_until(lock, retryAt, ready);
+            else wake.wait(lock, ready);
+            if (retryNow) {
+                retryNow = false;
+                backoff = std::chrono::seconds(0);
+                retryAt = Clock::now();
+            }
+
+            // Group commit: let a burst of events collect before touching the disk
+            if (!incoming.empty() && !stopping) wake.wait_for(lock, COMMIT_DELAY, [this] { return stopping.load(); });
+
+            batch.swap(incoming);
+            exiting = stopping;
+        }
+
+        if (!batch.empty()) commit(batch);
+        // Whatever is logged goes out on the next start; don't hold up shutdown on the network
+        if (exiting) return;
+
+        if (!unsent.empty() && Clock::now() >= retryAt && canSend()) {
+            if (send()) {
+                backoff = std::chrono::seconds(0);
+            } else {
+                backoff = backoff.count() ? std::min(backoff * 2, MAX_BACKOFF) : MIN_BACKOFF;
+                retryAt = Clock::now() + backoff;
+            }
+        }
+    }
+}
+
+// ---------------- Log ----------------
+// "E <seq> <event> <positionMs> <itemId>" for each event and "A <seq>" once
+// everything up to seq has been delivered. Fields are tab separated.
+
+void PlaybackReporter::replayLog() {
+    logFd = open(LOG_PATH, O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (logFd < 0) {
+        SDL_Log("Playback log unavailable, reports will not survive a restart");
+        return;
+    }
+
+    std::string text;
+    char buf[4096];
+    ssize_t n;
+    while ((n = read(logFd, buf, sizeof(buf))) > 0) text.append(buf, n);
+
+    // A power cut can leave the last line half written; drop it so the next
+    // append starts on a fresh line
+    size_t valid = text.rfind('\n') == std::string::npos ? 0 : text.rfind('\n') + 1;
+    if (valid < text.size()) {
+        text.resize(valid);
+        if (ftruncate(logFd, valid) != 0) SDL_Log("Could not trim playback log");
+    }
+
+    std::vector<Record> records;
+    uint64_t acked = 0;
+    std::istringstream lines(text);
+    std::string line;
+    while (std::getline(lines, line)) {
+        std::istringstream fields(line);
+        char kind = 0;
+        uint64_t seq = 0;
+        fields >> kind >> seq;
+        if (!fields) continue;
+        nextSeq = std::max(nextSeq, seq + 1);
+        if (kind == 'A') {
+            acked = std::max(acked, seq);
+            continue;
+        }
+        int event = 0;
+        Record r{seq, Event::Start, 0, ""};
+        if (kind != 'E' || !(fields >> event >> r.positionMs) || event < 0 || event > 2) continue;
+        fields.get();
+        std::getline(fields, r.itemId);
+        if (r.itemId.empty()) continue;
+        r.event = static_cast<Event>(event);
+        records.push_back(std::move(r));
+    }
+
+    for (auto &r : records)
+        if (r.seq > acked) unsent.push_back(std::move(r));
+    if (unsent.empty() && !text.empty() && ftruncate(logFd, 0) != 0)
+        SDL_Log("Could not trim playback log");
+}
+
+void PlaybackReporter::commit(std::vector<Record> &batch) {
+    std::ostringstream text;
+    bool mustSync = false;
+    for (auto &r : batch) {
+        r.seq = nextSeq++;
+        text << "E\t" << r.seq << '\t' << static_cast<int>(r.event) << '\t' << r.positionMs << '\t' << r.itemId << '\n';
+        // Losing a progress tick to a power cut only costs a few seconds of resume position
+        if (r.event != Event::Progress) mustSync = true;
+        unsent.push_back(std::move(r));
+    }
+
+    if (logFd < 0) return;
+    if (!writeAll(logFd, text.str())) SDL_Log("Playback log write failed");
+    else if (mustSync) fdatasync(logFd);
+}
+
+// ---------------- Sending ----------------
+
+void PlaybackReporter::coalesce() {
+    // Only the newest position of a play matters: drop a progress event when
+    // the next event for the same item is another progress or the stop
+    std::unordered_map<std::string, Event> later;
+    std::deque<Record> kept;
+    for (auto it = unsent.rbegin(); it != unsent.rend(); ++it) {
+        auto next = later.find(it->itemId);
+        bool superseded = it->event == Event::Progress && next != later.end() && next->second != Event::Start;
+        later[it->itemId] = it->event;
+        if (!superseded) kept.push_front(std::move(*it));
+    }
+    unsent.swap(kept);
+}
+
+bool PlaybackReporter::canSend() {
+    if (!jellyfin->configured()) return false;
+    // A refused login is retried only with new credentials
+    return !halted || jellyfin->generation() != haltedGeneration;
+}
+
+void PlaybackReporter::halt(long status) {
+    halted = true;
+    haltedGeneration = jellyfin->generation();
+    SDL_Log("Jellyfin refused playback reports (HTTP %ld); keeping them until the login changes", status);
+}
+
+bool PlaybackReporter::send() {
+    halted = false;
+    Jellyfin::Session session;
+    long login = jellyfin->session(session, stopping);
+    if (login == 401 || login == 403) {
+        halt(login);
+        return true;
+    }
+    if (login != 200) return false;
+
+    coalesce();
+    CURL *curl = curl_easy_init();
+    if (!curl) return false;
+
+    uint64_t delivered = 0;
+    bool ok = true;
+    while (!unsent.empty() && !stopping) {
+        const Record &r = unsent.front();
+        const char *endpoint = r.event == Event::Start ? "Playing"
+                             : r.event == Event::Progress ? "Playing/Progress"
+                             : "Playing/Stopped";
+        long status = Jellyfin::postPlayback(curl, session.serverUrl, session.accessToken, endpoint, r.itemId,
+                                             r.positionMs * 10000, stopping);
+        if (status == 401) {
+            // The token expired or was revoked; sign in again on the next attempt
+            jellyfin->invalidate(session.accessToken);
+            ok = false;
+            break;
+        }
+        if (status == 403) {
+            halt(status);
+            break;
+        }
+
+        bool accepted = status >= 200 && status < 300;
+        // The server will never take a malformed report or an unknown item; don't retry it forever
+        bool rejected = status == 400 || status == 404;
+        if (rejected) SDL_Log("Jellyfin rejected playback report for %s (HTTP %ld)", r.itemId.c_str(), status);
+        if (!accepted && !rejected) {
+            ok = false;
+            break;
+        }
+        delivered = r.seq;
+        unsent.pop_front();
+    }
+    curl_easy_cleanup(curl);
+
+    if (delivered && logFd >= 0) {
+        if (unsent.empty()) {
+            if (ftruncate(logFd, 0) != 0) SDL_Log("Could not trim playback log");
+        } else {
+            writeAll(logFd, "A\t" + std::to_string(delivered) + "\n");
+        }
+        fdatasync(logFd);
+    }
+    return ok;
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "JellyfinClient.h"
+
+// Reports playback start, progress and stop to Jellyfin without ever making
+// the UI thread wait on the disk or the network.
+//
+// report() only queues the event. A worker appends queued events to a small
+// write-ahead log (playback.wal) in groups, one write and one fdatasync per
+// group, then posts them to the server in order. Progress superseded by a later
+// event for the same play is dropped before sending. If the server cannot be
+// reached the worker retries with exponential backoff; anything not yet
+// acknowledged is still in the log after a power cut and is sent on next start.
+// If the server refuses the login (401/403) sending stops until the
+// credentials in Settings change; the events stay in the log meanwhile.
+class PlaybackReporter {
+public:
+    enum class Event { Start, Progress, Stop };
+
+    ~PlaybackReporter();
+
+    // Replays unsent events from the log and starts the worker. Events are
+    // logged even without a server and go out once one is configured.
+    // `jellyfin` must outlive the reporter.
+    void start(Jellyfin::Account &jellyfin);
+
+    // Queues an event. Never blocks on I/O.
+    void report(Event event, const std::string &itemId, int64_t positionMs);
+
+    // Call after the Jellyfin login changed in Settings: sends right away
+    // instead of waiting out a backoff or a refused login.
+    void loginChanged();
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Record {
+        uint64_t seq;
+        Event event;
+        int64_t positionMs;
+        std::string itemId;
+    };
+
+    void run();
+    void replayLog();
+    void commit(std::vector<Record> &batch);
+    bool canSend();
+    // Returns false if sending should be retried after a backoff.
+    bool send();
+    void coalesce();
+    void halt(long status);
+
+    Jellyfin::Account *jellyfin = nullptr;
+    int logFd = -1;
+
+    // Shared with the UI thread
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::vector<Record> incoming;
+    std::atomic<bool> stopping{false}; // set under the lock; also aborts requests in flight
+    bool retryNow = false;
+
+    // Worker only
+    std::thread worker;
+    uint64_t nextSeq = 1;
+    std::deque<Record> unsent; // logged, in order
+    Clock::time_point retryAt;
+    std::chrono::seconds backoff{0};
+    bool halted = false;
+    unsigned haltedGeneration = 0; // the account generation that was refused
+};
@@ -0,0 +1,69 @@
+#include "Session.h"
+#include "Utils.h"
+#include <algorithm>
+#include <fstream>
+#include <string>
+
+static const char *SESSION_PATH = "session.cfg";
+// Kept apart from the snapshot: it holds the password, so only the owner may read it
+static const char *CREDENTIALS_PATH = "credentials.cfg";
+
+// Calls `apply(key, value)` for each key=value line of `path`.
+template<typename Apply>
+static void readConfig(const char *path, Apply apply) {
+    std::ifstream in(path);
+    std::string line;
+    while (std::getline(in, line)) {
+        auto eq = line.find('=');
+        if (eq == std::string::npos) continue;
+        try {
+            apply(line.substr(0, eq), line.substr(eq + 1));
+        } catch (...) {
+            // corrupt value -> keep the default
+        }
+    }
+}
+
+void loadSession(AppState &state) {
+    bool legacyCredentials = false;
+    readConfig(SESSION_PATH, [&](const std::string &key, const std::string &value) {
+        if (key == "screen") {
+            int screen = std::stoi(value);
+            if (screen >= 0 && screen <= static_cast<int>(Screen::Playlists))
+                state.current = static_cast<Screen>(screen);
+        }
+        else if (key == "selected") state.selected = std::max(0, std::stoi(value));
+        // Older snapshots carried the Jellyfin settings; move them out below
+        else if (key == "jellyfinUrl") state.jellyfinUrl = value, legacyCredentials = true;
+        else if (key == "jellyfinUser") state.jellyfinUser = value, legacyCredentials = true;
+        else if (key == "jellyfinPass") state.jellyfinPass = value, legacyCredentials = true;
+    });
+    readConfig(CREDENTIALS_PATH, [&](const std::string &key, const std::string &value) {
+        if (key == "jellyfinUrl") state.jellyfinUrl = value;
+        else if (key == "jellyfinUser") state.jellyfinUser = value;
+        else if (key == "jellyfinPass") state.jellyfinPass = value;
+        else if (key == "jellyfinVerifyTls") state.jellyfinVerifyTls = value != "0";
+    });
+    state.visualOffset = (float) state.selected;
+
+    if (legacyCredentials) {
+        saveCredentials(state);
+        saveSession(state);
+    }
+}
+
+void saveSession(const AppState &state) {
+    writeFileAtomically(SESSION_PATH,
+                "screen=" + std::to_string(static_cast<int>(state.current)) + "\n" +
+                "selected=" + std::to_string(state.selected) + "\n",
+                0644);
+}
+
+void saveCredentials(const AppState &state) {
+    writeFileAtomically(CREDENTIALS_PATH,
+                "jellyfinUrl=" + state.jellyfinUrl + "\n" +
+                "jellyfinUser=" + state.jellyfinUser + "\n" +
+                "jellyfinPass=" + state.jellyfinPass + "\n" +
+                "jellyfinVerifyTls=" + (state.jellyfinVerifyTls ? "1" : "0") + "\n",
+                0600);
+}
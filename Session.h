@@ -0,0 +1,15 @@
+#pragma once
+#include "AppState.h"
+
+// Restores the screen and selection from the last run, and the Jellyfin
+// settings from credentials.cfg. Leaves `state` untouched if there is no
+// snapshot yet. The selection is only known to be non-negative; callers
+// check it against the list they index.
+void loadSession(AppState &state);
+
+// Writes the screen and selection restored by loadSession. The file is replaced
+// atomically so a power cut never leaves a half-written snapshot behind.
+void saveSession(const AppState &state);
+
+// Writes the Jellyfin settings to credentials.cfg, readable by the owner only.
+void saveCredentials(const AppState &state);
@@ -0,0 +1,172 @@
+#include "SmartPlaylists.h"
+#include "Utils.h"
+#include <SDL2/SDL.h>
+#include <algorithm>
+#include <ctime>
+#include <fstream>
+#include <sstream>
+
+static const char *STATS_PATH = "stats.log";
+static const char *PLAYLISTS_PATH = "playlists.txt";
+
+SmartPlaylists::~SmartPlaylists() {
+    if (compactor.joinable()) compactor.join();
+}
+
+void SmartPlaylists::load() {
+    // ---------------- Statistics ----------------
+    // One line per change: plays, last played, date added, path. Later lines win.
+    size_t lines = 0;
+    {
+        std::ifstream in(STATS_PATH);
+        std::string line;
+        while (std::getline(in, line)) {
+            std::istringstream fields(line);
+            Stats s;
+            std::string path;
+            if (!(fields >> s.playCount >> s.lastPlayed >> s.dateAdded)) continue; // torn write
+            fields.get();
+            std::getline(fields, path);
+            if (path.empty()) continue;
+            stats[path] = s;
+            lines++;
+        }
+    }
+
+    // Compact once the log is mostly superseded lines. The synced rewrite runs
+    // on its own thread; plays recorded meanwhile are held back and appended
+    // to whichever log survives, so none are lost to the rename.
+    if (lines > 2 * stats.size() + 100) {
+        std::ostringstream text;
+        for (auto &[path, s] : stats)
+            text << s.playCount << '\t' << s.lastPlayed << '\t' << s.dateAdded << '\t' << path << '\n';
+        compacting = true;
+        compactor = std::thread([this, text = text.str()]() {
+            if (!writeFileAtomically(STATS_PATH, text))
+                SDL_Log("Could not compact %s, keeping the full log", STATS_PATH);
+            std::lock_guard<std::mutex> lock(logMutex);
+            compacting = false;
+            if (!heldLines.empty()) {
+                std::ofstream(STATS_PATH, std::ios::app) << heldLines;
+                heldLines.clear();
+            }
+        });
+    }
+
+    // ---------------- Playlists ----------------
+    add("Most Played", "plays > 0 order by plays desc limit 25");
+    add("Recently Played", "lastplayed < 14d order by lastplayed desc limit 25");
+    add("Recently Added", "added < 30d order by added desc");
+    add("Not Played Lately", "lastplayed > 30d order by artist");
+
+    // User rules, one per line: "Name: rule"
+    std::ifstream in(PLAYLISTS_PATH);
+    std::string line;
+    while (std::getline(in, line)) {
+        auto colon = line.find(':');
+        if (line.empty() || line[0] == '#' || colon == std::string::npos) continue;
+        add(line.substr(0, colon), line.substr(colon + 1));
+    }
+}
+
+void SmartPlaylists::add(const std::string &name, const std::string &rule) {
+    std::string error;
+    auto query = SmartQuery::compile(rule, error);
+    if (!query) {
+        SDL_Log("Skipping playlist \"%s\": %s", name.c_str(), error.c_str());
+        return;
+    }
+    playlists.push_back({name, *query, {}, {}});
+}
+
+int SmartPlaylists::size(int i) const {
+    return (int) std::min(playlists[i].rows.size(), playlists[i].query.limit());
+}
+
+int SmartPlaylists::position(int i, int row) const {
+    const auto &rows = playlists[i].rows;
+    auto shown = rows.begin() + size(i);
+    auto found = std::find(rows.begin(), shown, row);
+    return found == shown ? -1 : int(found - rows.begin());
+}
+
+void SmartPlaylists::rebuild(std::vector<Song> &songs) {
+    int64_t now = std::time(nullptr);
+
+    std::vector<const Song *> firstSeen;
+    for (auto &song : songs) {
+        auto found = stats.find(song.filePath);
+        if (found != stats.end()) {
+            song.playCount = found->second.playCount;
+            song.lastPlayed = found->second.lastPlayed;
+            if (found->second.dateAdded) song.dateAdded = found->second.dateAdded;
+        } else if (!song.dateAdded) {
+            // Remote songs have no file time; remember when we first saw them
+            song.dateAdded = now;
+            stats[song.filePath] = {0, 0, now};
+            firstSeen.push_back(&song);
+        }
+    }
+    if (!firstSeen.empty()) appendStats(firstSeen);
+
+    columns.rebuild(songs);
+    for (auto &playlist : playlists) evaluate(playlist, now);
+    lastEvaluated = now;
+}
+
+void SmartPlaylists::refreshIfStale() {
+    int64_t now = std::time(nullptr);
+    if (now - lastEvaluated < 3600) return;
+    for (auto &playlist : playlists)
+        if (playlist.query.dependsOnTime()) evaluate(playlist, now);
+    lastEvaluated = now;
+}
+
+void SmartPlaylists::evaluate(SmartPlaylist &playlist, int64_t now) {
+    playlist.query.evaluate(columns, now, playlist.member);
+    playlist.rows.clear();
+    for (size_t row = 0; row < playlist.member.size(); row++)
+        if (playlist.member[row]) playlist.rows.push_back((int) row);
+    std::sort(playlist.rows.begin(), playlist.rows.end(), [&](int a, int b) {
+        return playlist.query.before(columns, a, b);
+    });
+}
+
+void SmartPlaylists::recordPlay(std::vector<Song> &songs, int row) {
+    if (row < 0 || row >= (int) songs.size() || row >= (int) columns.rows()) return;
+    int64_t now = std::time(nullptr);
+
+    // Take the row out while its old sort key is still in the columns
+    for (auto &playlist : playlists) {
+        if (!playlist.member[row]) continue;
+        auto cmp = [&](int a, int b) { return playlist.query.before(columns, a, b); };
+        auto it = std::lower_bound(playlist.rows.begin(), playlist.rows.end(), row, cmp);
+        if (it != playlist.rows.end() && *it == row) playlist.rows.erase(it);
+        playlist.member[row] = 0;
+    }
+
+    Song &song = songs[row];
+    song.playCount++;
+    song.lastPlayed = now;
+    columns.updateStats(row, song);
+    stats[song.filePath] = {song.playCount, song.lastPlayed, song.dateAdded};
+    appendStats({&song});
+
+    // ...and put it back wherever the new stats place it
+    for (auto &playlist : playlists) {
+        if (!playlist.query.matches(columns, row, now)) continue;
+        auto cmp = [&](int a, int b) { return playlist.query.before(columns, a, b); };
+        playlist.rows.insert(std::lower_bound(playlist.rows.begin(), playlist.rows.end(), row, cmp), row);
+        playlist.member[row] = 1;
+    }
+}
+
+void SmartPlaylists::appendStats(const std::vector<const Song *> &changed) {
+    std::ostringstream lines;
+    for (const Song *s : changed)
+        lines << s->playCount << '\t' << s->lastPlayed << '\t' << s->dateAdded << '\t' << s->filePath << '\n';
+
+    std::lock_guard<std::mutex> lock(logMutex);
+    if (compacting) heldLines += lines.str();
+    else std::ofstream(STATS_PATH, std::ios::app) << lines.str();
+}
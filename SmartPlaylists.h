@@ -0,0 +1,69 @@
+#pragma once
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "SmartQuery.h"
+#include "Song.h"
+
+struct SmartPlaylist {
+    std::string name;
+    SmartQuery query;
+    std::vector<int> rows;       // matching songs, in the rule's order
+    std::vector<uint8_t> member; // member[row] is 1 if row is in `rows`
+};
+
+// Keeps play statistics and the smart playlists built from them.
+//
+// Statistics live in an append-only log (stats.log) keyed by file path, so a
+// play costs one short append. Playlists are fully evaluated only when the
+// library changes shape; a play re-tests just the played song against each rule.
+class SmartPlaylists {
+public:
+    ~SmartPlaylists();
+
+    // Reads stats.log and the playlist rules (built-ins plus playlists.txt).
+    void load();
+
+    // Call after songs were added, removed or replaced: restores their stats,
+    // rebuilds the columns and re-evaluates every playlist.
+    void rebuild(std::vector<Song> &songs);
+
+    // Counts a play of songs[row] and updates each playlist for that row only.
+    void recordPlay(std::vector<Song> &songs, int row);
+
+    // Rules with relative ages ("added < 14d") drift as time passes; re-run
+    // them if the last full evaluation is more than an hour old.
+    void refreshIfStale();
+
+    int count() const { return (int) playlists.size(); }
+    const std::string &name(int i) const { return playlists[i].name; }
+    const std::vector<int> &rows(int i) const { return playlists[i].rows; }
+    // Number of rows shown, after the rule's limit.
+    int size(int i) const;
+    // Where songs[row] is shown in playlist i, or -1 if it is not shown.
+    int position(int i, int row) const;
+
+private:
+    struct Stats {
+        int playCount = 0;
+        int64_t lastPlayed = 0;
+        int64_t dateAdded = 0;
+    };
+
+    void add(const std::string &name, const std::string &rule);
+    void evaluate(SmartPlaylist &playlist, int64_t now);
+    void appendStats(const std::vector<const Song *> &changed);
+
+    std::vector<SmartPlaylist> playlists;
+    LibraryColumns columns;
+    std::unordered_map<std::string, Stats> stats;
+    int64_t lastEvaluated = 0;
+
+    // Log compaction in the background; appends wait in heldLines meanwhile
+    std::thread compactor;
+    std::mutex logMutex;
+    bool compacting = false;
+    std::string heldLines;
+};
@@ -0,0 +1,428 @@
+#include "SmartQuery.h"
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstring>
+#include <limits>
+
+static std::string lower(std::string s) {
+    std::transform(s.begin(), s.end(), s.begin(), [](unsigned char c) { return (char) std::tolower(c); });
+    return s;
+}
+
+// ------------------ COLUMNS ------------------
+
+void LibraryColumns::rebuild(const std::vector<Song> &songs) {
+    title.clear();
+    artist.clear();
+    playCount.clear();
+    lastPlayed.clear();
+    dateAdded.clear();
+    artistNames.clear();
+    artistIds.clear();
+
+    title.reserve(songs.size());
+    artist.reserve(songs.size());
+    for (const auto &s : songs) {
+        title.push_back(lower(s.title));
+        std::string name = lower(s.artist);
+        auto id = artistIds.emplace(name, (uint32_t) artistNames.size());
+        if (id.second) artistNames.push_back(name);
+        artist.push_back(id.first->second);
+        playCount.push_back(s.playCount);
+        lastPlayed.push_back(s.lastPlayed);
+        dateAdded.push_back(s.dateAdded);
+    }
+}
+
+void LibraryColumns::updateStats(size_t row, const Song &song) {
+    playCount[row] = song.playCount;
+    lastPlayed[row] = song.lastPlayed;
+    dateAdded[row] = song.dateAdded;
+}
+
+// ------------------ AST ------------------
+
+enum class Op { Eq, Ne, Lt, Le, Gt, Ge, Contains };
+
+struct SmartQuery::Node {
+    enum class Kind { Cond, And, Or, Not } kind;
+    Field field = Field::None;
+    Op op = Op::Eq;
+    int64_t number = 0; // plays, or an age in seconds
+    std::string text;   // lowercased
+    std::shared_ptr<const Node> a, b;
+};
+
+using Node = SmartQuery::Node;
+
+static bool isTextField(SmartQuery::Field f) {
+    return f == SmartQuery::Field::Title || f == SmartQuery::Field::Artist;
+}
+
+static bool isAgeField(SmartQuery::Field f) {
+    return f == SmartQuery::Field::LastPlayed || f == SmartQuery::Field::Added;
+}
+
+template<typename T>
+static bool compare(Op op, T lhs, T rhs) {
+    switch (op) {
+        case Op::Eq: return lhs == rhs;
+        case Op::Ne: return lhs != rhs;
+        case Op::Lt: return lhs < rhs;
+        case Op::Le: return lhs <= rhs;
+        case Op::Gt: return lhs > rhs;
+        case Op::Ge: return lhs >= rhs;
+        default: return false;
+    }
+}
+
+static int64_t age(int64_t timestamp, int64_t now) {
+    return timestamp ? now - timestamp : std::numeric_limits<int64_t>::max();
+}
+
+// ------------------ PARSER ------------------
+
+namespace {
+    struct Token {
+        enum class Type { Word, Number, TooLarge, String, Unterminated, Symbol, End } type = Type::End;
+        std::string text;
+        int64_t number = 0;
+        char unit = 0; // duration suffix on numbers: s, h, d, w or y
+    };
+
+    // Recursive descent over: or-expr := and-expr {"or" and-expr},
+    // and-expr := unary {"and" unary}, unary := "not" unary | "(" or-expr ")" | field op value
+    class Parser {
+    public:
+        explicit Parser(const std::string &src) : src(src) { next(); }
+
+        std::string error;
+        bool timeRelative = false;
+
+        bool atEnd() const { return tok.type == Token::Type::End; }
+        bool isWord(const char *word) const { return tok.type == Token::Type::Word && tok.text == word; }
+
+        bool fail(const std::string &message) {
+            if (error.empty()) error = message + " at '" + (atEnd() ? "end" : tok.text) + "'";
+            return false;
+        }
+
+        bool expectWord(const char *word) {
+            if (!isWord(word)) return fail(std::string("expected '") + word + "'");
+            next();
+            return true;
+        }
+
+        void next() {
+            while (pos < src.size() && std::isspace((unsigned char) src[pos])) pos++;
+            tok = {};
+            if (pos >= src.size()) return;
+
+            char c = src[pos];
+            if (std::isalpha((unsigned char) c)) {
+                size_t start = pos;
+                while (pos < src.size() && (std::isalnum((unsigned char) src[pos]) || src[pos] == '_')) pos++;
+                tok.type = Token::Type::Word;
+                tok.text = lower(src.substr(start, pos - start));
+            } else if (std::isdigit((unsigned char) c)) {
+                size_t start = pos;
+                while (pos < src.size() && std::isdigit((unsigned char) src[pos])) pos++;
+                tok.text = src.substr(start, pos - start);
+                auto parsed = std::from_chars(tok.text.data(), tok.text.data() + tok.text.size(), tok.number);
+                tok.type = parsed.ec == std::errc() ? Token::Type::Number : Token::Type::TooLarge;
+                if (pos < src.size() && std::strchr("shdwy", src[pos])) tok.unit = src[pos++];
+            } else if (c == '"') {
+                size_t end = src.find('"', pos + 1);
+                if (end == std::string::npos) {
+                    tok.type = Token::Type::Unterminated;
+                    tok.text = src.substr(pos);
+                    pos = src.size();
+                } else {
+                    tok.type = Token::Type::String;
+                    tok.text = src.substr(pos + 1, end - pos - 1);
+                    pos = end + 1;
+                }
+            } else {
+                bool twoChar = (c == '!' || c == '<' || c == '>') && pos + 1 < src.size() && src[pos + 1] == '=';
+                tok.type = Token::Type::Symbol;
+                tok.text = src.substr(pos, twoChar ? 2 : 1);
+                pos += tok.text.size();
+            }
+        }
+
+        bool parseField(SmartQuery::Field &field) {
+            if (tok.type != Token::Type::Word) return fail("expected a field");
+            if (tok.text == "title") field = SmartQuery::Field::Title;
+            else if (tok.text == "artist") field = SmartQuery::Field::Artist;
+            else if (tok.text == "plays") field = SmartQuery::Field::Plays;
+            else if (tok.text == "lastplayed") field = SmartQuery::Field::LastPlayed;
+            else if (tok.text == "added") field = SmartQuery::Field::Added;
+            else return fail("unknown field");
+            next();
+            return true;
+        }
+
+        bool parseNumber(int64_t &value) {
+            if (tok.type == Token::Type::TooLarge) return fail("number too large");
+            if (tok.type != Token::Type::Number || tok.unit) return fail("expected a number");
+            value = tok.number;
+            next();
+            return true;
+        }
+
+        std::shared_ptr<const Node> parseOr() {
+            auto left = parseAnd();
+            while (left && isWord("or")) {
+                next();
+                auto right = parseAnd();
+                if (!right) return nullptr;
+                left = combine(Node::Kind::Or, left, right);
+            }
+            return left;
+        }
+
+    private:
+        static std::shared_ptr<const Node> combine(Node::Kind kind, std::shared_ptr<const Node> a,
+                                                   std::shared_ptr<const Node> b) {
+            auto node = std::make_shared<Node>();
+            node->kind = kind;
+            node->a = std::move(a);
+            node->b = std::move(b);
+            return node;
+        }
+
+        std::shared_ptr<const Node> parseAnd() {
+            auto left = parseUnary();
+            while (left && isWord("and")) {
+                next();
+                auto right = parseUnary();
+                if (!right) return nullptr;
+                left = combine(Node::Kind::And, left, right);
+            }
+            return left;
+        }
+
+        std::shared_ptr<const Node> parseUnary() {
+            if (isWord("not")) {
+                next();
+                auto inner = parseUnary();
+                return inner ? combine(Node::Kind::Not, inner, nullptr) : nullptr;
+            }
+            if (tok.type == Token::Type::Symbol && tok.text == "(") {
+                next();
+                auto inner = parseOr();
+                if (!inner) return nullptr;
+                if (tok.type != Token::Type::Symbol || tok.text != ")") {
+                    fail("expected ')'");
+                    return nullptr;
+                }
+                next();
+                return inner;
+            }
+            return parseCondition();
+        }
+
+        bool parseOperator(Op &op) {
+            if (isWord("contains")) op = Op::Contains;
+            else if (tok.type != Token::Type::Symbol) return fail("expected an operator");
+            else if (tok.text == "=") op = Op::Eq;
+            else if (tok.text == "!=") op = Op::Ne;
+            else if (tok.text == "<") op = Op::Lt;
+            else if (tok.text == "<=") op = Op::Le;
+            else if (tok.text == ">") op = Op::Gt;
+            else if (tok.text == ">=") op = Op::Ge;
+            else return fail("expected an operator");
+            next();
+            return true;
+        }
+
+        bool parseValue(Node &node) {
+            if (isTextField(node.field)) {
+                if (node.op != Op::Eq && node.op != Op::Ne && node.op != Op::Contains)
+                    return fail("text fields support =, != and contains");
+                if (tok.type == Token::Type::Unterminated) return fail("unterminated string");
+                if (tok.type != Token::Type::String) return fail("expected a quoted string");
+                node.text = lower(tok.text);
+            } else if (node.op == Op::Contains) {
+                return fail("contains needs a text field");
+            } else if (tok.type == Token::Type::TooLarge) {
+                return fail("number too large");
+            } else if (isAgeField(node.field)) {
+                if (tok.type != Token::Type::Number) return fail("expected an age such as 30d");
+                // Plain numbers are days
+                int64_t unit = 86400;
+                if (tok.unit == 's') unit = 1;
+                else if (tok.unit == 'h') unit = 3600;
+                else if (tok.unit == 'w') unit = 7 * 86400;
+                else if (tok.unit == 'y') unit = 365 * 86400;
+                if (tok.number > std::numeric_limits<int64_t>::max() / unit) return fail("age too large");
+                node.number = tok.number * unit;
+                timeRelative = true;
+            } else {
+                if (tok.type != Token::Type::Number || tok.unit) return fail("expected a number");
+                node.number = tok.number;
+            }
+            next();
+            return true;
+        }
+
+        std::shared_ptr<const Node> parseCondition() {
+            auto node = std::make_shared<Node>();
+            node->kind = Node::Kind::Cond;
+            if (!parseField(node->field) || !parseOperator(node->op) || !parseValue(*node)) return nullptr;
+            return node;
+        }
+
+        const std::string &src;
+        size_t pos = 0;
+        Token tok;
+    };
+}
+
+std::optional<SmartQuery> SmartQuery::compile(const std::string &text, std::string &error) {
+    Parser parser(text);
+    SmartQuery query;
+
+    if (!parser.atEnd() && !parser.isWord("order") && !parser.isWord("limit")) {
+        query.root = parser.parseOr();
+        if (!query.root) {
+            error = parser.error;
+            return std::nullopt;
+        }
+    }
+    if (parser.isWord("order")) {
+        parser.next();
+        if (!parser.expectWord("by") || !parser.parseField(query.orderBy)) {
+            error = parser.error;
+            return std::nullopt;
+        }
+        if (parser.isWord("desc")) {
+            query.descending = true;
+            parser.next();
+        } else if (parser.isWord("asc")) {
+            parser.next();
+        }
+    }
+    if (parser.isWord("limit")) {
+        parser.next();
+        int64_t limit = 0;
+        if (!parser.parseNumber(limit)) {
+            error = parser.error;
+            return std::nullopt;
+        }
+        query.maxRows = (size_t) limit;
+    }
+    if (!parser.atEnd()) {
+        parser.fail("unexpected input");
+        error = parser.error;
+        return std::nullopt;
+    }
+
+    query.timeRelative = parser.timeRelative;
+    return query;
+}
+
+// ------------------ EVALUATION ------------------
+
+// Artist names are interned; compare ids rather than strings. -1 never matches.
+static int64_t resolveArtist(const Node &n, const LibraryColumns &c) {
+    auto found = c.artistIds.find(n.text);
+    return found == c.artistIds.end() ? -1 : (int64_t) found->second;
+}
+
+static bool matchRow(const Node &n, const LibraryColumns &c, size_t row, int64_t now) {
+    switch (n.kind) {
+        case Node::Kind::And: return matchRow(*n.a, c, row, now) && matchRow(*n.b, c, row, now);
+        case Node::Kind::Or: return matchRow(*n.a, c, row, now) || matchRow(*n.b, c, row, now);
+        case Node::Kind::Not: return !matchRow(*n.a, c, row, now);
+        case Node::Kind::Cond: break;
+    }
+
+    switch (n.field) {
+        case SmartQuery::Field::Title:
+            if (n.op == Op::Contains) return c.title[row].find(n.text) != std::string::npos;
+            return compare(n.op, c.title[row], n.text);
+        case SmartQuery::Field::Artist:
+            if (n.op == Op::Contains) return c.artistNames[c.artist[row]].find(n.text) != std::string::npos;
+            return compare(n.op, (int64_t) c.artist[row], resolveArtist(n, c));
+        case SmartQuery::Field::Plays: return compare(n.op, (int64_t) c.playCount[row], n.number);
+        case SmartQuery::Field::LastPlayed: return compare(n.op, age(c.lastPlayed[row], now), n.number);
+        case SmartQuery::Field::Added: return compare(n.op, age(c.dateAdded[row], now), n.number);
+        default: return false;
+    }
+}
+
+static void evalColumn(const Node &n, const LibraryColumns &c, int64_t now, std::vector<uint8_t> &out) {
+    size_t rows = c.rows();
+    out.assign(rows, 0);
+
+    switch (n.kind) {
+        case Node::Kind::And:
+        case Node::Kind::Or: {
+            std::vector<uint8_t> rhs;
+            evalColumn(*n.a, c, now, out);
+            evalColumn(*n.b, c, now, rhs);
+            if (n.kind == Node::Kind::And) for (size_t i = 0; i < rows; i++) out[i] &= rhs[i];
+            else for (size_t i = 0; i < rows; i++) out[i] |= rhs[i];
+            return;
+        }
+        case Node::Kind::Not:
+            evalColumn(*n.a, c, now, out);
+            for (size_t i = 0; i < rows; i++) out[i] ^= 1;
+            return;
+        case Node::Kind::Cond: break;
+    }
+
+    // One tight loop over a single column per condition
+    switch (n.field) {
+        case SmartQuery::Field::Artist:
+            if (n.op != Op::Contains) {
+                int64_t id = resolveArtist(n, c);
+                for (size_t i = 0; i < rows; i++) out[i] = compare(n.op, (int64_t) c.artist[i], id);
+                return;
+            }
+            break;
+        case SmartQuery::Field::Plays:
+            for (size_t i = 0; i < rows; i++) out[i] = compare(n.op, (int64_t) c.playCount[i], n.number);
+            return;
+        case SmartQuery::Field::LastPlayed:
+            for (size_t i = 0; i < rows; i++) out[i] = compare(n.op, age(c.lastPlayed[i], now), n.number);
+            return;
+        case SmartQuery::Field::Added:
+            for (size_t i = 0; i < rows; i++) out[i] = compare(n.op, age(c.dateAdded[i], now), n.number);
+            return;
+        default: break;
+    }
+    for (size_t i = 0; i < rows; i++) out[i] = matchRow(n, c, i, now);
+}
+
+void SmartQuery::evaluate(const LibraryColumns &columns, int64_t now, std::vector<uint8_t> &out) const {
+    if (!root) out.assign(columns.rows(), 1);
+    else evalColumn(*root, columns, now, out);
+}
+
+bool SmartQuery::matches(const LibraryColumns &columns, size_t row, int64_t now) const {
+    return !root || matchRow(*root, columns, row, now);
+}
+
+bool SmartQuery::before(const LibraryColumns &c, size_t a, size_t b) const {
+    auto key = [&](auto &column) -> int {
+        if (column[a] == column[b]) return 0;
+        return (column[a] < column[b]) != descending ? -1 : 1;
+    };
+
+    int order = 0;
+    switch (orderBy) {
+        case Field::Title: order = key(c.title); break;
+        case Field::Artist:
+            if (c.artist[a] != c.artist[b])
+                order = (c.artistNames[c.artist[a]] < c.artistNames[c.artist[b]]) != descending ? -1 : 1;
+            break;
+        case Field::Plays: order = key(c.playCount); break;
+        case Field::LastPlayed: order = key(c.lastPlayed); break;
+        case Field::Added: order = key(c.dateAdded); break;
+        case Field::None: break;
+    }
+    return order ? order < 0 : a < b;
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Song.h"
+
+// Column-oriented copy of the fields smart playlists filter and sort on.
+// Row i is songs[i]. Text is lowercased once here so matching is case-insensitive.
+struct LibraryColumns {
+    std::vector<std::string> title;
+    std::vector<uint32_t> artist; // index into artistNames
+    std::vector<int> playCount;
+    std::vector<int64_t> lastPlayed;
+    std::vector<int64_t> dateAdded;
+
+    std::vector<std::string> artistNames;
+    std::unordered_map<std::string, uint32_t> artistIds;
+
+    size_t rows() const { return title.size(); }
+
+    void rebuild(const std::vector<Song> &songs);
+    // Refreshes the play statistics of one row.
+    void updateStats(size_t row, const Song &song);
+};
+
+// A compiled smart playlist rule, e.g.
+//
+//     artist = "Daft Punk" and lastplayed > 30d order by plays desc limit 25
+//
+// Fields: title, artist (text: =, !=, contains), plays (number), lastplayed and
+// added (ages such as 12h, 30d, 2w; a song never played is infinitely old).
+// Conditions combine with and, or, not and parentheses. An empty rule matches
+// every song.
+class SmartQuery {
+public:
+    enum class Field { Title, Artist, Plays, LastPlayed, Added, None };
+
+    // Returns std::nullopt and sets `error` if `text` does not parse.
+    static std::optional<SmartQuery> compile(const std::string &text, std::string &error);
+
+    // Evaluates the filter one column at a time into `out` (1 = match), one entry per row.
+    void evaluate(const LibraryColumns &columns, int64_t now, std::vector<uint8_t> &out) const;
+    // Evaluates the filter for a single row, for incremental updates.
+    bool matches(const LibraryColumns &columns, size_t row, int64_t now) const;
+
+    // Strict ordering of rows by the rule's "order by", ties broken by library order.
+    bool before(const LibraryColumns &columns, size_t a, size_t b) const;
+
+    bool dependsOnTime() const { return timeRelative; }
+    size_t limit() const { return maxRows; }
+
+    struct Node;
+
+private:
+    std::shared_ptr<const Node> root; // null matches everything
+    Field orderBy = Field::None;
+    bool descending = false;
+    size_t maxRows = SIZE_MAX;
+    bool timeRelative = false;
+};
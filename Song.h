@@ -2,6 +2,7 @@
 // File: Song.h
 #pragma once
 #include <string>
+#include <cstdint>
 #include <memory>
 #include <SDL2/SDL.h>
 
@@ -10,7 +11,13 @@ struct Song {
     std::string title;
     std::string artist;
     std::string filePath;      // local path or remote URL
+    std::string jellyfinId;    // server item id; empty for local files
     std::shared_ptr<SDL_Texture> artwork; // optional; nullptr if not loaded
 
+    // Play statistics, unix seconds (0 = never)
+    int playCount = 0;
+    int64_t lastPlayed = 0;
+    int64_t dateAdded = 0;
+
     Song() = default;
 };
\ No newline at end of file
@@ -0,0 +1,129 @@
+#include "SongCache.h"
+#include <SDL2/SDL.h>
+#include <algorithm>
+
+namespace fs = std::filesystem;
+
+static const fs::path SONG_CACHE_DIR = "cache/songs";
+
+SongCache::SongCache(Jellyfin::Account &account) : jellyfin(account) {
+    worker = std::thread(&SongCache::workLoop, this);
+}
+
+SongCache::~SongCache() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        cancel = true;
+    }
+    cv.notify_all();
+    worker.join();
+}
+
+fs::path SongCache::copyPath(const std::string &jellyfinId) {
+    return SONG_CACHE_DIR / jellyfinId;
+}
+
+std::string SongCache::localPath(const Song &song) {
+    if (song.jellyfinId.empty()) return "";
+    fs::path path = copyPath(song.jellyfinId);
+    std::error_code ec;
+    if (!fs::exists(path, ec)) return "";
+    // The modification time doubles as "last played" for pruning
+    fs::last_write_time(path, fs::file_time_type::clock::now(), ec);
+    return path.string();
+}
+
+void SongCache::request(const Song &song) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        wanted = song;
+        cancel = true;
+    }
+    cv.notify_all();
+}
+
+bool SongCache::poll(Fetched &out) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (results.empty()) return false;
+    out = std::move(results.front());
+    results.erase(results.begin());
+    return true;
+}
+
+void SongCache::workLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        cv.wait(lock, [this] { return stopping || !wanted.filePath.empty(); });
+        if (stopping) return;
+        Song song = std::move(wanted);
+        wanted = Song();
+        cancel = false;
+        lock.unlock();
+
+        fs::path path = copyPath(song.jellyfinId);
+        fs::path part = path;
+        part += ".part";
+        std::error_code ec;
+        fs::create_directories(SONG_CACHE_DIR, ec);
+
+        Fetched fetched{song.filePath, ""};
+        long status = fetch(song.filePath, part.string());
+        if (status == 200) {
+            fs::rename(part, path, ec);
+            if (!ec) fetched.localPath = path.string();
+            prune(path);
+        } else {
+            fs::remove(part, ec);
+            if (!cancel) SDL_Log("Could not download %s (HTTP %ld)", song.title.c_str(), status);
+        }
+
+        lock.lock();
+        // A cancelled transfer was superseded; nobody is waiting for it
+        if (!cancel || !fetched.localPath.empty()) results.push_back(std::move(fetched));
+    }
+}
+
+long SongCache::fetch(const std::string &fileUrl, const std::string &destPath) {
+    Jellyfin::Session session;
+    long status = jellyfin.session(session, cancel);
+    if (status != 200) return status;
+    status = Jellyfin::download(fileUrl, session.accessToken, destPath, cancel);
+    if (status == 401) {
+        // The token was revoked or expired; sign in again once
+        jellyfin.invalidate(session.accessToken);
+        if (jellyfin.session(session, cancel) == 200)
+            status = Jellyfin::download(fileUrl, session.accessToken, destPath, cancel);
+    }
+    return status;
+}
+
+void SongCache::prune(const fs::path &keep) {
+    struct Entry {
+        fs::path path;
+        uintmax_t size;
+        fs::file_time_type used;
+    };
+    std::vector<Entry> entries;
+    uintmax_t total = 0;
+    std::error_code ec;
+    for (const auto &entry : fs::directory_iterator(SONG_CACHE_DIR, ec)) {
+        if (!entry.is_regular_file(ec)) continue;
+        if (entry.path().extension() == ".part") {
+            // Left behind by a power cut; the only live transfer has just finished
+            fs::remove(entry.path(), ec);
+            continue;
+        }
+        uintmax_t size = entry.file_size(ec);
+        entries.push_back({entry.path(), size, entry.last_write_time(ec)});
+        total += size;
+    }
+    if (total <= CACHE_LIMIT_BYTES) return;
+
+    std::sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b) { return a.used < b.used; });
+    for (const auto &entry : entries) {
+        if (total <= CACHE_LIMIT_BYTES) break;
+        if (entry.path == keep) continue;
+        if (fs::remove(entry.path, ec)) total -= entry.size;
+    }
+}
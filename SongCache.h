@@ -0,0 +1,54 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "JellyfinClient.h"
+#include "Song.h"
+
+// Local copies of Jellyfin songs, since SDL_mixer only opens files.
+//
+// Songs are downloaded on a worker thread into cache/songs, one at a time. A
+// new request cancels a download that is still running, so skipping through
+// songs never queues up transfers. The folder is capped in size; the least
+// recently played copies go first.
+class SongCache {
+public:
+    // `jellyfin` must outlive the cache.
+    explicit SongCache(Jellyfin::Account &jellyfin);
+    ~SongCache();
+
+    // Path of the local copy of `song`, or empty if there is none yet.
+    std::string localPath(const Song &song);
+
+    // Starts downloading `song`, replacing any earlier request.
+    void request(const Song &song);
+
+    struct Fetched {
+        std::string filePath;  // the song's filePath
+        std::string localPath; // empty if the download failed
+    };
+    // Moves a finished download into `out`. Returns false if there was none.
+    bool poll(Fetched &out);
+
+private:
+    static constexpr uintmax_t CACHE_LIMIT_BYTES = 512ull * 1024 * 1024;
+
+    static std::filesystem::path copyPath(const std::string &jellyfinId);
+
+    void workLoop();
+    long fetch(const std::string &fileUrl, const std::string &destPath);
+    void prune(const std::filesystem::path &keep);
+
+    Jellyfin::Account &jellyfin;
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool stopping = false;
+    std::atomic<bool> cancel{false}; // aborts the running transfer
+    Song wanted;                     // next song to fetch, empty filePath if none
+    std::vector<Fetched> results;
+};
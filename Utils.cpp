@@ -1,12 +1,21 @@
 #include "Utils.h"
 #include "JellyfinClient.h"
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <fcntl.h>
+#include <filesystem>
+#include <mutex>
+#include <sys/stat.h>
+#include <unistd.h>
 
 std::vector<Song> loadJellyfinSongs(SDL_Renderer * /*renderer*/,
                                     const std::string &serverUrl,
-                                    const std::string &apiKey,
+                                    const std::string &accessToken,
+                                    const std::atomic<bool> &cancel,
                                     const std::string &userId,
                                     const std::string &libraryId) {
-    return Jellyfin::fetchSongs(serverUrl, apiKey, userId, libraryId);
+    return Jellyfin::fetchSongs(serverUrl, accessToken, cancel, userId, libraryId);
 }
 
 SDL_Texture *renderText(SDL_Renderer *r, TTF_Font *font, const std::string &text, SDL_Color color) {
@@ -102,3 +111,52 @@ void drawHighlight(SDL_Renderer *r, const SDL_Rect &rect) {
     SDL_SetRenderDrawColor(r, 255, 255, 255, 60);
     SDL_RenderDrawLine(r, rect.x, rect.y, rect.x + rect.w, rect.y);
 }
+
+void startupTrace(const char *phase) {
+    using Clock = std::chrono::steady_clock;
+    static const Clock::time_point launch = Clock::now();
+    static Clock::time_point last = launch;
+    static std::mutex mutex;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    Clock::time_point now = Clock::now();
+    auto ms = [](Clock::duration d) { return (long long) std::chrono::duration_cast<std::chrono::milliseconds>(d).count(); };
+    SDL_Log("startup: %-20s +%4lld ms (%lld ms)", phase, ms(now - last), ms(now - launch));
+    last = now;
+}
+
+bool writeFileAtomically(const std::string &path, const std::string &text, unsigned mode) {
+    std::string tmpPath = path + ".tmp";
+    int fd = open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, mode);
+    if (fd < 0) return false;
+    fchmod(fd, mode); // a leftover tmp file keeps its old mode otherwise
+
+    const char *p = text.data();
+    size_t left = text.size();
+    bool ok = true;
+    while (left > 0) {
+        ssize_t n = write(fd, p, left);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            ok = false;
+            break;
+        }
+        p += n;
+        left -= n;
+    }
+    ok = ok && fsync(fd) == 0;
+    ok = close(fd) == 0 && ok;
+    if (!ok || std::rename(tmpPath.c_str(), path.c_str()) != 0) {
+        std::remove(tmpPath.c_str());
+        return false;
+    }
+
+    // Make the rename itself durable
+    std::string dir = std::filesystem::path(path).parent_path().string();
+    int dirFd = open(dir.empty() ? "." : dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dirFd >= 0) {
+        fsync(dirFd);
+        close(dirFd);
+    }
+    return true;
+}
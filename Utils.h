@@ -1,14 +1,17 @@
 #pragma once
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_ttf.h>
+#include <atomic>
 #include <string>
 #include <vector>
 #include "Song.h" // provide Song definition
 
-// Call this to fetch songs from Jellyfin. Returns Song objects with filePath set to a stream/download URL.
+// Call this to fetch songs from Jellyfin. Returns Song objects with filePath set to a download URL.
+// Setting `cancel` aborts the request.
 std::vector<Song> loadJellyfinSongs(SDL_Renderer *renderer,
                                     const std::string &serverUrl,
-                                    const std::string &apiKey,
+                                    const std::string &accessToken,
+                                    const std::atomic<bool> &cancel,
                                     const std::string &userId = "",
                                     const std::string &libraryId = "");
 
@@ -17,3 +20,11 @@ SDL_Texture *renderText(SDL_Renderer *renderer, TTF_Font *font, const std::strin
 void drawTopBar(SDL_Renderer *r, TTF_Font *font, const std::string &title, int winWidth, int batteryPercent = 100);
 
 void drawHighlight(SDL_Renderer *renderer, const SDL_Rect &rect);
+
+// Logs a startup phase with the time since the previous phase and since launch.
+void startupTrace(const char *phase);
+
+// Replaces `path` with `text` so that after a crash or power cut it holds
+// either the old or the new contents: writes a temporary file, syncs it and
+// renames it over `path`. Returns false, leaving `path` untouched, on any error.
+bool writeFileAtomically(const std::string &path, const std::string &text, unsigned mode = 0644);
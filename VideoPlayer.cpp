@@ -0,0 +1,386 @@
+#include "VideoPlayer.h"
+#include <SDL2/SDL_mixer.h>
+#include <algorithm>
+#include <cstring>
+
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+#include <libswscale/swscale.h>
+#include <libswresample/swresample.h>
+}
+
+static AVCodecContext *openCodec(AVStream *stream) {
+    const AVCodec *codec = avcodec_find_decoder(stream->codecpar->codec_id);
+    if (!codec) return nullptr;
+
+    AVCodecContext *ctx = avcodec_alloc_context3(codec);
+    if (!ctx) return nullptr;
+    if (avcodec_parameters_to_context(ctx, stream->codecpar) < 0) {
+        avcodec_free_context(&ctx);
+        return nullptr;
+    }
+    // Software decoding, spread over all cores
+    ctx->thread_count = 0;
+    ctx->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
+    ctx->flags2 |= AV_CODEC_FLAG2_FAST;
+    ctx->pkt_timebase = stream->time_base;
+    if (avcodec_open2(ctx, codec, nullptr) < 0) {
+        avcodec_free_context(&ctx);
+        return nullptr;
+    }
+    return ctx;
+}
+
+VideoPlayer::~VideoPlayer() {
+    close();
+}
+
+bool VideoPlayer::open(const std::string &path) {
+    close();
+
+    if (avformat_open_input(&format, path.c_str(), nullptr, nullptr) < 0) {
+        SDL_Log("Could not open video %s", path.c_str());
+        format = nullptr;
+        return false;
+    }
+    if (avformat_find_stream_info(format, nullptr) < 0) {
+        close();
+        return false;
+    }
+
+    videoStream = av_find_best_stream(format, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+    if (videoStream < 0 || !(videoCodec = openCodec(format->streams[videoStream]))) {
+        SDL_Log("No playable video stream in %s", path.c_str());
+        close();
+        return false;
+    }
+    AVRational rate = av_guess_frame_rate(format, format->streams[videoStream], nullptr);
+    if (rate.num > 0 && rate.den > 0) frameDuration = av_q2d(av_inv_q(rate));
+
+    // ---------------- Audio ----------------
+    audioStream = av_find_best_stream(format, AVMEDIA_TYPE_AUDIO, -1, videoStream, nullptr, 0);
+    Uint16 mixFormat = 0;
+    if (audioStream >= 0 && Mix_QuerySpec(&mixRate, &mixFormat, &mixChannels) && mixFormat == AUDIO_S16SYS)
+        audioCodec = openCodec(format->streams[audioStream]);
+    if (audioCodec) {
+        AVChannelLayout outLayout;
+        av_channel_layout_default(&outLayout, mixChannels);
+        if (swr_alloc_set_opts2(&swr, &outLayout, AV_SAMPLE_FMT_S16, mixRate,
+                                &audioCodec->ch_layout, audioCodec->sample_fmt, audioCodec->sample_rate,
+                                0, nullptr) < 0 || swr_init(swr) < 0) {
+            swr_free(&swr);
+            avcodec_free_context(&audioCodec);
+        }
+        av_channel_layout_uninit(&outLayout);
+    }
+    if (!audioCodec) audioStream = -1;
+
+    // Let the demuxer skip everything we do not decode
+    for (unsigned i = 0; i < format->nb_streams; i++) {
+        if ((int) i != videoStream && (int) i != audioStream)
+            format->streams[i]->discard = AVDISCARD_ALL;
+    }
+
+    if (audioCodec) {
+        // Half a second of S16 PCM
+        audioRing.assign(size_t(mixRate / 2) * mixChannels * 2, 0);
+        Mix_HookMusic(mixAudio, this);
+    }
+    decoder = std::thread(&VideoPlayer::decodeLoop, this);
+    return true;
+}
+
+void VideoPlayer::close() {
+    // Mix_HookMusic locks the audio device, so no callback is running after this
+    if (audioCodec) Mix_HookMusic(nullptr, nullptr);
+
+    // Set the flag under both locks so the decoder cannot test its wait
+    // condition, miss the flag and then sleep through the notify
+    {
+        std::lock_guard<std::mutex> frameLock(frameMutex);
+        std::lock_guard<std::mutex> audioLock(audioMutex);
+        stopRequested = true;
+    }
+    frameCv.notify_all();
+    audioCv.notify_all();
+    if (decoder.joinable()) decoder.join();
+
+    for (auto &f : frames) av_frame_free(&f.frame);
+    frames.clear();
+    sws_freeContext(sws);
+    sws = nullptr;
+    swr_free(&swr);
+    avcodec_free_context(&videoCodec);
+    avcodec_free_context(&audioCodec);
+    avformat_close_input(&format);
+    if (texture) SDL_DestroyTexture(texture);
+    texture = nullptr;
+
+    videoStream = -1;
+    audioStream = -1;
+    frameDuration = 1.0 / 25.0;
+    lastVideoPts = 0.0;
+    audioRead = 0;
+    audioSize = 0;
+    audioEndPts = -1.0;
+    samplesPlayed = 0;
+    chunkSamples = 0;
+    chunkStart = 0;
+    clockRunning = false;
+    behind = false;
+    decodeDone = false;
+    stopRequested = false;
+}
+
+bool VideoPlayer::ended() {
+    std::lock_guard<std::mutex> lock(frameMutex);
+    return decodeDone && frames.empty();
+}
+
+// ------------------ DECODER THREAD ------------------
+
+void VideoPlayer::decodeLoop() {
+    AVPacket *pkt = av_packet_alloc();
+    while (!stopRequested && av_read_frame(format, pkt) >= 0) {
+        if (pkt->stream_index == videoStream) decodeVideo(pkt);
+        else if (pkt->stream_index == audioStream) decodeAudio(pkt);
+        av_packet_unref(pkt);
+    }
+    // Drain the frames the decoders are still holding on to
+    if (!stopRequested) {
+        decodeVideo(nullptr);
+        if (audioCodec) decodeAudio(nullptr);
+    }
+    av_packet_free(&pkt);
+    decodeDone = true;
+}
+
+void VideoPlayer::decodeVideo(AVPacket *pkt) {
+    // While the render thread is dropping frames, stop decoding the ones nothing depends on
+    videoCodec->skip_frame = behind ? AVDISCARD_NONREF : AVDISCARD_DEFAULT;
+
+    if (avcodec_send_packet(videoCodec, pkt) < 0) return;
+    AVFrame *frame = av_frame_alloc();
+    while (!stopRequested && avcodec_receive_frame(videoCodec, frame) == 0)
+        pushVideoFrame(frame);
+    av_frame_free(&frame);
+}
+
+void VideoPlayer::pushVideoFrame(AVFrame *decoded) {
+    AVFrame *out = av_frame_alloc();
+    if (decoded->format == AV_PIX_FMT_YUV420P || decoded->format == AV_PIX_FMT_YUVJ420P) {
+        // Already in the texture's layout: hand over the decoder's buffer as is
+        av_frame_move_ref(out, decoded);
+    } else {
+        // Other YUV layouts are repacked to planar 4:2:0, still without going through RGB
+        sws = sws_getCachedContext(sws, decoded->width, decoded->height, (AVPixelFormat) decoded->format,
+                                   decoded->width, decoded->height, AV_PIX_FMT_YUV420P,
+                                   SWS_FAST_BILINEAR, nullptr, nullptr, nullptr);
+        out->format = AV_PIX_FMT_YUV420P;
+        out->width = decoded->width;
+        out->height = decoded->height;
+        if (!sws || av_frame_get_buffer(out, 0) < 0) {
+            av_frame_free(&out);
+            av_frame_unref(decoded);
+            return;
+        }
+        sws_scale(sws, decoded->data, decoded->linesize, 0, decoded->height, out->data, out->linesize);
+        out->best_effort_timestamp = decoded->best_effort_timestamp;
+        av_frame_unref(decoded);
+    }
+
+    double pts = lastVideoPts + frameDuration;
+    if (out->best_effort_timestamp != AV_NOPTS_VALUE)
+        pts = out->best_effort_timestamp * av_q2d(format->streams[videoStream]->time_base);
+    lastVideoPts = pts;
+
+    std::unique_lock<std::mutex> lock(frameMutex);
+    frameCv.wait(lock, [this] { return frames.size() < FRAME_QUEUE_SIZE || stopRequested; });
+    if (stopRequested) {
+        av_frame_free(&out);
+        return;
+    }
+    frames.push_back({out, pts});
+}
+
+void VideoPlayer::decodeAudio(AVPacket *pkt) {
+    if (avcodec_send_packet(audioCodec, pkt) < 0) return;
+    AVFrame *frame = av_frame_alloc();
+    std::vector<uint8_t> pcm;
+    while (!stopRequested && avcodec_receive_frame(audioCodec, frame) == 0) {
+        int maxSamples = swr_get_out_samples(swr, frame->nb_samples);
+        pcm.resize(size_t(std::max(maxSamples, 0)) * mixChannels * 2);
+        uint8_t *out = pcm.data();
+        int samples = swr_convert(swr, &out, maxSamples, (const uint8_t **) frame->extended_data, frame->nb_samples);
+
+        double pts = -1.0;
+        if (frame->best_effort_timestamp != AV_NOPTS_VALUE)
+            pts = frame->best_effort_timestamp * av_q2d(format->streams[audioStream]->time_base);
+        if (samples > 0) pushAudio(pcm.data(), size_t(samples) * mixChannels * 2, pts);
+        av_frame_unref(frame);
+    }
+    av_frame_free(&frame);
+}
+
+void VideoPlayer::pushAudio(const uint8_t *data, size_t bytes, double pts) {
+    // Audio that is already behind the picture would only push the two further apart
+    double duration = double(bytes) / (mixChannels * 2) / mixRate;
+    if (clockRunning && pts >= 0.0 && pts + duration < clock()) return;
+
+    std::unique_lock<std::mutex> lock(audioMutex);
+    size_t written = 0;
+    while (written < bytes) {
+        if (!clockRunning && audioSize == audioRing.size()) {
+            // Nothing drains the ring before the first picture; drop the oldest audio
+            // rather than block the demuxer from reaching that picture
+            size_t drop = std::min(bytes - written, audioSize);
+            audioRead = (audioRead + drop) % audioRing.size();
+            audioSize -= drop;
+        }
+        audioCv.wait(lock, [this] { return audioSize < audioRing.size() || stopRequested; });
+        if (stopRequested) return;
+
+        size_t chunk = std::min(bytes - written, audioRing.size() - audioSize);
+        size_t writePos = (audioRead + audioSize) % audioRing.size();
+        size_t first = std::min(chunk, audioRing.size() - writePos);
+        std::memcpy(&audioRing[writePos], data + written, first);
+        std::memcpy(&audioRing[0], data + written + first, chunk - first);
+        audioSize += chunk;
+        written += chunk;
+        double bytesPerSecond = double(mixRate) * mixChannels * 2;
+        if (pts >= 0.0) audioEndPts = pts + written / bytesPerSecond;
+        else if (audioEndPts >= 0.0) audioEndPts += chunk / bytesPerSecond;
+    }
+}
+
+void VideoPlayer::alignAudio(double pts) {
+    // The ring may start before the first picture (its head was kept while the
+    // demuxer searched for a keyframe) or after it (the streams start at
+    // different times). Line its head up with `pts` so the offset does not
+    // persist for the whole video.
+    std::lock_guard<std::mutex> lock(audioMutex);
+    if (audioEndPts < 0.0 || audioRing.empty()) return;
+    size_t frameBytes = size_t(mixChannels) * 2;
+    double bytesPerSecond = double(mixRate) * frameBytes;
+    double headPts = audioEndPts - audioSize / bytesPerSecond;
+
+    if (headPts < pts) {
+        size_t drop = std::min(audioSize, size_t((pts - headPts) * bytesPerSecond) / frameBytes * frameBytes);
+        audioRead = (audioRead + drop) % audioRing.size();
+        audioSize -= drop;
+    } else {
+        // Start with silence until the first sample is due
+        size_t pad = std::min(audioRing.size() - audioSize,
+                              size_t((headPts - pts) * bytesPerSecond) / frameBytes * frameBytes);
+        audioRead = (audioRead + audioRing.size() - pad) % audioRing.size();
+        size_t first = std::min(pad, audioRing.size() - audioRead);
+        std::memset(&audioRing[audioRead], 0, first);
+        std::memset(&audioRing[0], 0, pad - first);
+        audioSize += pad;
+    }
+}
+
+// ------------------ AUDIO CALLBACK ------------------
+
+void VideoPlayer::mixAudio(void *udata, Uint8 *stream, int len) {
+    auto *self = static_cast<VideoPlayer *>(udata);
+    size_t copied = 0;
+
+    // Stay silent until the first picture is up so both start together
+    if (self->clockRunning) {
+        std::lock_guard<std::mutex> lock(self->audioMutex);
+        copied = std::min(size_t(len), self->audioSize);
+        size_t first = std::min(copied, self->audioRing.size() - self->audioRead);
+        std::memcpy(stream, &self->audioRing[self->audioRead], first);
+        std::memcpy(stream + first, &self->audioRing[0], copied - first);
+        self->audioRead = (self->audioRead + copied) % self->audioRing.size();
+        self->audioSize -= copied;
+    }
+    self->audioCv.notify_one();
+    std::memset(stream + copied, 0, len - copied);
+
+    // Underruns still advance the clock, so the picture never waits on a starved decoder
+    if (self->clockRunning) {
+        std::lock_guard<std::mutex> lock(self->clockMutex);
+        self->samplesPlayed += self->chunkSamples;
+        self->chunkSamples = len / (self->mixChannels * 2);
+        self->chunkStart = SDL_GetPerformanceCounter();
+    }
+}
+
+// ------------------ RENDER THREAD ------------------
+
+double VideoPlayer::clock() const {
+    if (!clockRunning) return clockBase;
+    if (audioCodec) {
+        std::lock_guard<std::mutex> lock(clockMutex);
+        if (!chunkStart) return clockBase;
+        // Into the current chunk by the time since it was taken, but never past its end
+        double intoChunk = double(SDL_GetPerformanceCounter() - chunkStart) / SDL_GetPerformanceFrequency();
+        intoChunk = std::min(intoChunk, double(chunkSamples) / mixRate);
+        return clockBase + double(samplesPlayed) / mixRate + intoChunk;
+    }
+    return clockBase + double(SDL_GetPerformanceCounter() - wallStart) / SDL_GetPerformanceFrequency();
+}
+
+void VideoPlayer::present(SDL_Renderer *r, int winWidth, int winHeight) {
+    AVFrame *due = nullptr;
+    int dropped = 0;
+    {
+        std::lock_guard<std::mutex> lock(frameMutex);
+        if (!clockRunning) {
+            if (!frames.empty()) {
+                due = frames.front().frame;
+                clockBase = frames.front().pts;
+                if (audioCodec) alignAudio(clockBase);
+                wallStart = SDL_GetPerformanceCounter();
+                frames.pop_front();
+                clockRunning = true;
+            }
+        } else {
+            // A frame more than a frame duration behind the clock is late; skip it
+            // if a newer due frame can take its place. Otherwise show the oldest
+            // due frame and leave the next one for the next refresh.
+            double now = clock();
+            while (frames.size() > 1 && frames[1].pts <= now && frames.front().pts + frameDuration < now) {
+                av_frame_free(&frames.front().frame);
+                frames.pop_front();
+                dropped++;
+            }
+            if (!frames.empty() && frames.front().pts <= now) {
+                due = frames.front().frame;
+                frames.pop_front();
+            }
+        }
+    }
+    frameCv.notify_one();
+    if (dropped) behind = true;
+    else if (due) behind = false;
+
+    if (due) {
+        if (!texture || textureW != due->width || textureH != due->height) {
+            if (texture) SDL_DestroyTexture(texture);
+            texture = SDL_CreateTexture(r, SDL_PIXELFORMAT_IYUV, SDL_TEXTUREACCESS_STREAMING, due->width, due->height);
+            textureW = due->width;
+            textureH = due->height;
+        }
+        if (texture)
+            SDL_UpdateYUVTexture(texture, nullptr,
+                                 due->data[0], due->linesize[0],
+                                 due->data[1], due->linesize[1],
+                                 due->data[2], due->linesize[2]);
+        av_frame_free(&due);
+    }
+
+    SDL_SetRenderDrawColor(r, 0, 0, 0, 255);
+    SDL_Rect screen{0, 0, winWidth, winHeight};
+    SDL_RenderFillRect(r, &screen);
+    if (!texture) return;
+
+    float scale = std::min(winWidth / float(textureW), winHeight / float(textureH));
+    int w = int(textureW * scale);
+    int h = int(textureH * scale);
+    SDL_Rect dst{(winWidth - w) / 2, (winHeight - h) / 2, w, h};
+    SDL_RenderCopy(r, texture, nullptr, &dst);
+}
@@ -0,0 +1,103 @@
+#pragma once
+#include <SDL2/SDL.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct AVFormatContext;
+struct AVCodecContext;
+struct AVFrame;
+struct AVPacket;
+struct SwsContext;
+struct SwrContext;
+
+// Plays a video file: demuxing and decoding happen on a worker thread that
+// fills a small frame queue, the render thread uploads due frames into a
+// streaming IYUV texture. Audio is fed to SDL_mixer through Mix_HookMusic
+// and the samples it consumes drive the presentation clock.
+class VideoPlayer {
+public:
+    ~VideoPlayer();
+
+    // Opens `path` and starts decoding. Audio replaces the music channel, so
+    // halt any playing music first.
+    bool open(const std::string &path);
+    void close();
+
+    bool isOpen() const { return format != nullptr; }
+    // True once the whole file has been decoded and shown.
+    bool ended();
+
+    // Uploads the frame due at the current clock, dropping any that are late,
+    // and draws the latest frame letterboxed into the window.
+    void present(SDL_Renderer *r, int winWidth, int winHeight);
+
+private:
+    struct QueuedFrame {
+        AVFrame *frame;
+        double pts; // seconds
+    };
+
+    static constexpr size_t FRAME_QUEUE_SIZE = 6;
+
+    void decodeLoop();
+    void decodeVideo(AVPacket *pkt);
+    void decodeAudio(AVPacket *pkt);
+    void pushVideoFrame(AVFrame *frame);
+    void pushAudio(const uint8_t *data, size_t bytes, double pts);
+    void alignAudio(double pts);
+    double clock() const;
+
+    static void mixAudio(void *udata, Uint8 *stream, int len);
+
+    AVFormatContext *format = nullptr;
+    AVCodecContext *videoCodec = nullptr;
+    AVCodecContext *audioCodec = nullptr;
+    SwsContext *sws = nullptr;
+    SwrContext *swr = nullptr;
+    int videoStream = -1;
+    int audioStream = -1;
+    double frameDuration = 1.0 / 25.0; // used when a frame carries no timestamp
+    double lastVideoPts = 0.0;
+
+    std::thread decoder;
+    std::atomic<bool> stopRequested{false};
+    std::atomic<bool> decodeDone{false};
+    std::atomic<bool> behind{false}; // set by the render thread when it drops frames
+
+    std::mutex frameMutex;
+    std::condition_variable frameCv;
+    std::deque<QueuedFrame> frames;
+
+    // Mixer output format, from Mix_QuerySpec
+    int mixRate = 44100;
+    int mixChannels = 2;
+
+    // PCM ring filled by the decoder and drained by the mixer callback
+    std::mutex audioMutex;
+    std::condition_variable audioCv;
+    std::vector<uint8_t> audioRing;
+    size_t audioRead = 0;
+    size_t audioSize = 0;
+    double audioEndPts = -1.0; // timestamp just past the newest sample in the ring, -1 if unknown
+
+    // Presentation clock: starts at the first shown frame and then advances with
+    // the samples the mixer consumes (or wall time if the file has no audio).
+    // The mixer takes audio in chunks of ~46 ms, longer than a frame, so the
+    // clock is interpolated from when the current chunk was taken.
+    std::atomic<bool> clockRunning{false};
+    mutable std::mutex clockMutex;
+    int64_t samplesPlayed = 0; // before the current chunk
+    int64_t chunkSamples = 0;
+    Uint64 chunkStart = 0;     // performance counter when the current chunk was taken
+    double clockBase = 0.0;
+    Uint64 wallStart = 0;
+
+    SDL_Texture *texture = nullptr;
+    int textureW = 0;
+    int textureH = 0;
+};
@@ -8,41 +8,151 @@
 #include "Pages/SettingsPage.h"
 #include "Pages/AboutPage.h"
 #include "Pages/MusicPage.h"
+#include "Pages/VideoPage.h"
+#include "Pages/PhotosPage.h"
+#include "Pages/PlaylistsPage.h"
+#include "Library.h"
+#include "LibraryWatcher.h"
+#include "SmartPlaylists.h"
+#include "PlaybackReporter.h"
+#include "SongCache.h"
+#include "Session.h"
+#include <algorithm>
+#include <optional>
 #include <vector>
 #include <string>
 
 int main(int argc, char **argv) {
-    // ------------------ SDL INIT ------------------
-    SDL_StartTextInput();
-    SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO);
-    TTF_Init();
-    IMG_Init(IMG_INIT_PNG);
-    if (Mix_OpenAudio(44100, MIX_DEFAULT_FORMAT, 2, 2048) < 0)
-        SDL_Log("SDL_mixer could not initialize! SDL_mixer Error: %s\n", Mix_GetError());
+    startupTrace("launch");
 
+    // ------------------ SDL INIT ------------------
+    // Only what the first frame needs. Images, audio and the library come up
+    // after the main menu is on screen.
+    SDL_Init(SDL_INIT_VIDEO);
     SDL_Window *window = SDL_CreateWindow("iPodOS", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
                                           0, 0, SDL_WINDOW_FULLSCREEN_DESKTOP);
     SDL_Renderer *renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
+    SDL_StartTextInput();
+    startupTrace("window created");
 
+    TTF_Init();
     TTF_Font *font = TTF_OpenFont("assets/fonts/MyriadPro-Regular.otf", 18);
+    startupTrace("font loaded");
 
     // ------------------ APP STATE ------------------
     AppState state;
+    loadSession(state);
     std::vector<MenuItem> mainMenu{
         {"Music", Screen::Music},
         {"Videos", Screen::Video},
-        {"Photos", Screen::Music},
+        {"Photos", Screen::Photos},
         {"Podcasts", Screen::Music},
-        {"Extras", Screen::Music},
+        {"Playlists", Screen::Playlists},
         {"Settings", Screen::Settings},
         {"Shuffle Songs", Screen::Settings},
         {"Now Playing", Screen::Music},
         {"About", Screen::About}
     };
+    // A stale or hand-edited snapshot may point past the end of the menu
+    if (state.current == Screen::MainMenu && state.selected >= (int) mainMenu.size()) state.selected = 0;
 
-    std::vector<Song> songs = loadSongs(renderer);
-    const Song *currentSong = nullptr;
+    // Declared before everything that talks to the server, so it outlives their threads
+    Jellyfin::Account jellyfin;
+    jellyfin.configure(state.jellyfinUrl, state.jellyfinUser, state.jellyfinPass, state.jellyfinVerifyTls);
+
+    std::vector<Song> songs;
+    std::optional<Song> currentSong; // a copy, so library updates never invalidate it
     Mix_Music *currentMusic = nullptr;
+    std::string awaitedSong; // filePath of a Jellyfin song waiting for its download
+    VideoPage videoPage;
+    PhotosPage photosPage;
+    SongCache songCache(jellyfin);
+    LibraryLoader library;
+    SmartPlaylists playlists;
+    LibraryWatcher watcher;
+    LibraryUpdate libraryUpdate;
+    LibraryIndex libraryIndex;
+    PlaybackReporter reporter;
+    bool startupDone = false;
+
+    // Jellyfin item of the song playing, empty for local files or nothing playing
+    std::string reportingItem;
+    Uint32 playStartedAt = 0, lastProgressAt = 0;
+    constexpr Uint32 PROGRESS_INTERVAL_MS = 10000;
+    auto stopReporting = [&]() {
+        if (reportingItem.empty()) return;
+        reporter.report(PlaybackReporter::Event::Stop, reportingItem, SDL_GetTicks() - playStartedAt);
+        reportingItem.clear();
+    };
+
+    // Entries in the list the Playlists screen is showing
+    auto playlistItems = [&]() {
+        return state.openPlaylist < 0 ? playlists.count() : playlists.size(state.openPlaylist);
+    };
+
+    // Runs `change`, which may reorder the open playlist or shift song rows,
+    // and keeps the cursor on the song it was on (tracked by path, as rows move).
+    auto keepPlaylistCursor = [&](auto change) {
+        bool inPlaylist = state.current == Screen::Playlists && state.openPlaylist >= 0 &&
+                          state.selected < playlistItems();
+        std::string underCursor = inPlaylist ? songs[playlists.rows(state.openPlaylist)[state.selected]].filePath : "";
+        change();
+        if (!inPlaylist) return;
+        auto found = libraryIndex.byPath.find(underCursor);
+        int moved = found != libraryIndex.byPath.end() ? playlists.position(state.openPlaylist, (int) found->second) : -1;
+        if (moved >= 0) {
+            state.visualOffset += moved - state.selected;
+            state.selected = moved;
+        } else {
+            state.selected = std::max(0, std::min(state.selected, playlistItems() - 1));
+        }
+    };
+
+    auto stopMusic = [&]() {
+        stopReporting();
+        awaitedSong.clear();
+        if (currentMusic) {
+            Mix_HaltMusic();
+            Mix_FreeMusic(currentMusic);
+            currentMusic = nullptr;
+        }
+    };
+
+    // Plays songs[index] from `path`, a local file
+    auto startSong = [&](int index, const std::string &path) {
+        currentMusic = Mix_LoadMUS(path.c_str());
+        if (!currentMusic || Mix_PlayMusic(currentMusic, 1) != 0) {
+            SDL_Log("Could not play %s: %s", songs[index].filePath.c_str(), Mix_GetError());
+            return;
+        }
+
+        // Only a play that actually started counts
+        keepPlaylistCursor([&]() { playlists.recordPlay(songs, index); });
+        currentSong = songs[index];
+
+        if (!currentSong->jellyfinId.empty()) {
+            reportingItem = currentSong->jellyfinId;
+            playStartedAt = lastProgressAt = SDL_GetTicks();
+            reporter.report(PlaybackReporter::Event::Start, reportingItem, 0);
+        }
+    };
+
+    auto playSong = [&](int index) {
+        stopMusic();
+        currentSong = songs[index];
+        if (songs[index].jellyfinId.empty()) {
+            startSong(index, songs[index].filePath);
+            return;
+        }
+        // SDL_mixer only opens files; remote songs play from a local copy
+        std::string local = songCache.localPath(songs[index]);
+        if (!local.empty()) {
+            startSong(index, local);
+        } else {
+            awaitedSong = songs[index].filePath;
+            songCache.request(songs[index]);
+        }
+    };
 
     // ------------------ MAIN LOOP ------------------
     bool running = true;
@@ -58,40 +168,98 @@ int main(int argc, char **argv) {
                     case SDLK_UP:
                         if (state.current == Screen::MainMenu)
                             state.selected = (state.selected - 1 + mainMenu.size()) % mainMenu.size();
-                        else if (state.current == Screen::Music)
+                        else if (state.current == Screen::Music && !songs.empty())
                             state.selected = (state.selected - 1 + songs.size()) % songs.size();
+                        else if (state.current == Screen::Video && !videoPage.isPlaying() && videoPage.count() > 0)
+                            state.selected = (state.selected - 1 + videoPage.count()) % videoPage.count();
+                        else if (state.current == Screen::Photos && photosPage.count() > 0)
+                            state.selected = photosPage.above(state.selected);
+                        else if (state.current == Screen::Playlists && playlistItems() > 0)
+                            state.selected = (state.selected - 1 + playlistItems()) % playlistItems();
                         else if (state.current == Screen::Settings)
-                            state.selected = (state.selected - 1 + 6) % 6; // 6 settings items
+                            state.selected = (state.selected - 1 + 9) % 9; // 9 settings items
                         break;
                     case SDLK_DOWN:
                         if (state.current == Screen::MainMenu)
                             state.selected = (state.selected + 1) % mainMenu.size();
-                        else if (state.current == Screen::Music)
+                        else if (state.current == Screen::Music && !songs.empty())
                             state.selected = (state.selected + 1) % songs.size();
+                        else if (state.current == Screen::Video && !videoPage.isPlaying() && videoPage.count() > 0)
+                            state.selected = (state.selected + 1) % videoPage.count();
+                        else if (state.current == Screen::Photos && photosPage.count() > 0)
+                            state.selected = photosPage.below(state.selected);
+                        else if (state.current == Screen::Playlists && playlistItems() > 0)
+                            state.selected = (state.selected + 1) % playlistItems();
                         else if (state.current == Screen::Settings)
-                            state.selected = (state.selected + 1) % 8;
+                            state.selected = (state.selected + 1) % 9;
+                        break;
+                    case SDLK_LEFT:
+                        if (state.current == Screen::Photos && photosPage.count() > 0)
+                            state.selected = (state.selected - 1 + photosPage.count()) % photosPage.count();
+                        break;
+                    case SDLK_RIGHT:
+                        if (state.current == Screen::Photos && photosPage.count() > 0)
+                            state.selected = (state.selected + 1) % photosPage.count();
                         break;
                     case SDLK_RETURN:
-                        if (state.current == Screen::MainMenu)
+                        if (state.current == Screen::MainMenu) {
                             state.current = mainMenu[state.selected].next;
-                        else if (state.current == Screen::Music) {
-                            currentSong = &songs[state.selected];
-                            if (currentMusic) {
-                                Mix_HaltMusic();
-                                Mix_FreeMusic(currentMusic);
+                            state.selected = 0;
+                            state.visualOffset = 0.0f;
+                            if (state.current == Screen::Video) videoPage.refresh();
+                            if (state.current == Screen::Photos) photosPage.refresh();
+                            if (state.current == Screen::Playlists) {
+                                playlists.refreshIfStale();
+                                state.openPlaylist = -1;
                             }
-                            currentMusic = Mix_LoadMUS(currentSong->filePath.c_str());
-                            if (currentMusic) Mix_PlayMusic(currentMusic, 1);
+                            saveSession(state);
+                        } else if (state.current == Screen::Music && state.selected < (int) songs.size()) {
+                            playSong(state.selected);
+                        } else if (state.current == Screen::Playlists && state.selected < playlistItems()) {
+                            if (state.openPlaylist < 0) {
+                                state.openPlaylist = state.selected;
+                                state.selected = 0;
+                                state.visualOffset = 0.0f;
+                            } else {
+                                playSong(playlists.rows(state.openPlaylist)[state.selected]);
+                            }
+                        } else if (state.current == Screen::Video && !videoPage.isPlaying()) {
+                            // the video's audio takes over the music channel
+                            stopMusic();
+                            currentSong.reset();
+                            videoPage.play(state.selected);
+                        } else if (state.current == Screen::Photos && state.selected < photosPage.count()) {
+                            photosPage.view();
                         } else if (state.current == Screen::Settings) {
-                            if (state.selected == 5) {
+                            if (state.selected == 6) { // "Add Jellyfin Server"
                                 state.inputMode = SettingsInputMode::JellyfinUrl;
+                            } else if (state.selected == 7) {
+                                state.jellyfinVerifyTls = !state.jellyfinVerifyTls;
+                                saveCredentials(state);
+                                jellyfin.configure(state.jellyfinUrl, state.jellyfinUser, state.jellyfinPass,
+                                                   state.jellyfinVerifyTls);
+                                reporter.loginChanged();
                             }
                         }
 
                         break;
                     case SDLK_BACKSPACE:
+                        if (state.current == Screen::Video && videoPage.isPlaying()) {
+                            videoPage.stop();
+                            break;
+                        }
+                        if (state.current == Screen::Photos && photosPage.isViewing()) {
+                            photosPage.closeViewer();
+                            break;
+                        }
+                        if (state.current == Screen::Playlists && state.openPlaylist >= 0) {
+                            state.selected = state.openPlaylist;
+                            state.openPlaylist = -1;
+                            break;
+                        }
                         state.current = Screen::MainMenu;
                         state.selected = 0; // reset selection to top
+                        saveSession(state);
                         break;
                 }
             }
@@ -121,13 +289,47 @@ int main(int argc, char **argv) {
                         state.inputMode = SettingsInputMode::JellyfinUser;
                     else if (state.inputMode == SettingsInputMode::JellyfinUser)
                         state.inputMode = SettingsInputMode::JellyfinPass;
-                    else
+                    else {
                         state.inputMode = SettingsInputMode::None; // finished
+                        saveCredentials(state);
+                        jellyfin.configure(state.jellyfinUrl, state.jellyfinUser, state.jellyfinPass, state.jellyfinVerifyTls);
+                        reporter.loginChanged();
+                    }
                 }
             }
         }
 
 
+        // Scan results first, so a newer state from the watcher wins within the batch
+        if (library.poll(libraryUpdate)) watcher.claimScan(libraryUpdate);
+        watcher.poll(libraryUpdate);
+        if (!libraryUpdate.empty()) {
+            keepPlaylistCursor([&]() {
+                applyLibraryUpdate(libraryUpdate, songs, libraryIndex, state);
+                playlists.rebuild(songs);
+            });
+        }
+        uploadLibraryArtwork(renderer, songs, libraryIndex);
+
+        SongCache::Fetched fetched;
+        while (songCache.poll(fetched)) {
+            if (fetched.filePath != awaitedSong) continue;
+            awaitedSong.clear();
+            auto it = std::find_if(songs.begin(), songs.end(),
+                                   [&](const Song &s) { return s.filePath == fetched.filePath; });
+            if (!fetched.localPath.empty() && it != songs.end())
+                startSong(int(it - songs.begin()), fetched.localPath);
+        }
+
+        if (!reportingItem.empty()) {
+            if (!Mix_PlayingMusic()) {
+                stopReporting();
+            } else if (SDL_GetTicks() - lastProgressAt >= PROGRESS_INTERVAL_MS) {
+                lastProgressAt = SDL_GetTicks();
+                reporter.report(PlaybackReporter::Event::Progress, reportingItem, lastProgressAt - playStartedAt);
+            }
+        }
+
         int winWidth, winHeight;
         SDL_GetWindowSize(window, &winWidth, &winHeight);
 
@@ -141,26 +343,60 @@ int main(int argc, char **argv) {
                 break;
             case Screen::Music:
                 if (currentSong)
-                    drawMusicScreen(renderer, font, currentSong, winWidth, winHeight);
+                    drawMusicScreen(renderer, font, &*currentSong, winWidth, winHeight);
                 else
                     drawSongsMenu(renderer, font, state, songs, winWidth, winHeight);
                 break;
             case Screen::Video:
-                drawTopBar(renderer, font, "Videos", winWidth);
+                videoPage.draw(renderer, font, state, winWidth, winHeight);
+                break;
             case Screen::Settings:
                 drawSettingsPage(renderer, font, state, winWidth, winHeight);
                 break;
             case Screen::About:
                 drawAboutPage(renderer, font, winWidth);
                 break;
+            case Screen::Photos:
+                photosPage.draw(renderer, font, state, winWidth, winHeight);
+                break;
+            case Screen::Playlists:
+                drawPlaylistsPage(renderer, font, state, playlists, songs, winWidth, winHeight);
+                break;
         }
 
         SDL_RenderPresent(renderer);
+
+        // ------------------ DEFERRED INIT ------------------
+        if (!startupDone) {
+            startupDone = true;
+            startupTrace("first frame");
+
+            IMG_Init(IMG_INIT_PNG);
+            playlists.load();
+            // watch before scanning so nothing copied in meanwhile is missed
+            watcher.start("assets/music");
+            library.start(jellyfin);
+            reporter.start(jellyfin);
+            startupTrace("library started");
+            if (state.current == Screen::Video) videoPage.refresh();
+            if (state.current == Screen::Photos) photosPage.refresh();
+
+            SDL_InitSubSystem(SDL_INIT_AUDIO);
+            if (Mix_OpenAudio(44100, MIX_DEFAULT_FORMAT, 2, 2048) < 0)
+                SDL_Log("SDL_mixer could not initialize! SDL_mixer Error: %s\n", Mix_GetError());
+            startupTrace("audio ready");
+        }
     }
 
     // ------------------ CLEANUP ------------------
-    for (auto &s: songs) if (s.artwork) SDL_DestroyTexture(s.artwork.get());
-    if (currentMusic) Mix_FreeMusic(currentMusic);
+    saveSession(state);
+    // artwork textures own themselves; release them before the renderer goes away
+    songs.clear();
+    stopMusic();
+    currentSong.reset();
+    videoPage.stop();
+    photosPage.unload();
+    Mix_CloseAudio();
     TTF_CloseFont(font);
     SDL_DestroyRenderer(renderer);
     SDL_DestroyWindow(window);
@@ -6,7 +6,8 @@ set -e  # exit on any error
 # -----------------------------
 sudo apt update
 sudo apt install -y git build-essential cmake libsdl2-dev libsdl2-ttf-dev \
-    libsdl2-image-dev libsdl2-mixer-dev xserver-xorg xinit openbox alsa-utils
+    libsdl2-image-dev libsdl2-mixer-dev libavformat-dev libavcodec-dev \
+    libswscale-dev libswresample-dev libjpeg-dev xserver-xorg xinit openbox alsa-utils
 
 # -----------------------------
 # 2) Clone and build PiPod OS